@@ -0,0 +1,79 @@
+// Example 2: Out Of Core
+//
+// Write a .obj with all of its vertices before all of its faces,
+//	load it with LoadFileOutOfCore and check that the peak resident
+//	memory stayed within the budget. Exits with 1 when it did not.
+//
+// Usage: e2_outofcore [vertex count] [budget in MiB]
+
+// Iostream - STD I/O Library
+#include <iostream>
+
+// fStream - STD File I/O Library
+#include <fstream>
+
+// OBJ Out Of Core Loader
+#include "obj_outofcore.h"
+
+// cStdio - std::remove
+#include <cstdio>
+
+// Resource Usage - peak resident memory
+#include <sys/resource.h>
+
+// Peak resident memory of this process in bytes
+static size_t PeakResident()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// Main function
+int main(int argc, char* argv[])
+{
+	size_t vertexCount = argc > 1 ? std::stoul(argv[1]) : 4000000;
+	size_t budget = (argc > 2 ? std::stoul(argv[2]) : 32) << 20;
+
+	// Write the vertices, then a strip of faces over all of them,
+	//	so the whole v table is written before any face reads it
+	{
+		std::ofstream file("e2Big.obj");
+		for (size_t i = 0; i < vertexCount; i++)
+			file << "v " << i % 1000 << " " << i / 1000 % 1000 << " " << i / 1000000 << "\n";
+		for (size_t i = 1; i + 2 <= vertexCount; i++)
+			file << "f " << i << " " << i + 1 << " " << i + 2 << "\n";
+	}
+
+	// The table alone is larger than the budget
+	std::cout << "Position table: " << (vertexCount * 12 >> 20) << " MiB, budget: " << (budget >> 20) << " MiB\n";
+
+	// Load it with bounded memory
+	MeshStore store;
+	OutOfCoreOptions options;
+	options.MemoryBudget = budget;
+
+	if (!LoadFileOutOfCore("e2Big.obj", store, options))
+	{
+		std::cout << "Failed to load e2Big.obj\n";
+		return 1;
+	}
+
+	size_t peak = PeakResident();
+	std::cout << "newMeshes: " << store.Count() << ", peak resident: " << (peak >> 20) << " MiB\n";
+
+	std::remove("e2Big.obj");
+
+	// Check the peak against the budget
+	if (peak > budget)
+	{
+		std::cout << "Peak resident memory is over the budget\n";
+		return 1;
+	}
+
+	return 0;
+}
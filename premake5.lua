@@ -1,6 +1,10 @@
+newoption { trigger = "with-zlib", description = "Read compressed .obj.gz files (links zlib)" }
+newoption { trigger = "with-zstd", description = "Read compressed .obj.zst files (links zstd)" }
+
 project "objloader"
     kind "StaticLib"
     language "C"
+    cppdialect "C++17"
     staticruntime "on"
     
     targetdir ("bin/" .. outputdir .. "/%{prj.name}")
@@ -29,3 +33,11 @@ project "objloader"
     filter "configurations:Release"
         runtime "Release"
         optimize "on"
+
+    filter "options:with-zlib"
+        defines { "OBJL_USE_ZLIB" }
+        links { "z" }
+
+    filter "options:with-zstd"
+        defines { "OBJL_USE_ZSTD" }
+        links { "zstd" }
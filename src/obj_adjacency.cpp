@@ -0,0 +1,143 @@
+// obj_adjacency.cpp - Half-edge adjacency through parallel radix sort of edge keys
+
+#include <obj_adjacency.h>
+#include <obj_parallel.h>
+#include <obj_polygon.h>
+#include <obj_radix.h>
+#include <obj_remap.h>
+
+#include <algorithm>
+#include <cstdint>
+
+// Half-edges each block of key building gets
+static const size_t kBlockSize = 16384;
+
+// Build the half-edge adjacency of an index list
+void BuildAdjacency(Adjacency& oAdjacency,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    const AdjacencyOptions& options)
+{
+    oAdjacency = Adjacency();
+
+    std::vector<unsigned int>& remap = oAdjacency.PositionRemap;
+    if (options.WeldPositions)
+    {
+        std::vector<unsigned int> first;
+        BuildRemap(remap, first, iVerts, [](const Vertex& v) -> const glm::vec3& { return v.Position; });
+        oAdjacency.PositionCount = (unsigned int)first.size();
+    }
+    else
+    {
+        remap.resize(iVerts.size());
+        for (size_t i = 0; i < remap.size(); i++)
+            remap[i] = (unsigned int)i;
+        oAdjacency.PositionCount = (unsigned int)iVerts.size();
+    }
+
+    size_t n = iIndices.size() / 3 * 3;
+    oAdjacency.Twin.assign(n, OBJL_NO_TWIN);
+    if (n == 0)
+        return;
+
+    // Key of an edge: larger end point above the smaller one
+    unsigned int bits = 1;
+    while (bits < 32 && (1ull << bits) < oAdjacency.PositionCount)
+        bits++;
+    const uint64_t mask = (1ull << bits) - 1;
+
+    // Degenerate half-edges get a key no real edge can have
+    //	(both ends equal) which sorts after all of them
+    const uint64_t degenerateKey = (mask << bits) | mask;
+
+    std::vector<uint64_t> keys(n);
+    std::vector<unsigned int> halfEdges(n);
+
+    const size_t blockSize = kBlockSize;
+    ParallelFor((n + blockSize - 1) / blockSize, [&](size_t b)
+    {
+        size_t end = std::min(n, (b + 1) * blockSize);
+        for (size_t h = b * blockSize; h < end; h++)
+        {
+            uint64_t a = remap[iIndices[h]];
+            uint64_t c = remap[iIndices[Adjacency::Next((unsigned int)h)]];
+            keys[h] = a == c ? degenerateKey : (std::max(a, c) << bits) | std::min(a, c);
+            halfEdges[h] = (unsigned int)h;
+        }
+    }, options.MaxThreads);
+
+    RadixSortPairs(keys, halfEdges, 2 * bits, options.MaxThreads);
+
+    // Runs of equal keys are the half-edges of one edge
+    auto forward = [&](unsigned int h)
+    {
+        return remap[iIndices[h]] < remap[iIndices[Adjacency::Next(h)]];
+    };
+
+    size_t i = 0;
+    while (i < n && keys[i] != degenerateKey)
+    {
+        size_t end = i + 1;
+        while (end < n && keys[end] == keys[i])
+            end++;
+
+        oAdjacency.Edges++;
+        if (end - i == 1)
+        {
+            oAdjacency.BoundaryEdges++;
+        }
+        else if (end - i == 2)
+        {
+            unsigned int h0 = halfEdges[i], h1 = halfEdges[i + 1];
+            oAdjacency.Twin[h0] = h1;
+            oAdjacency.Twin[h1] = h0;
+            if (forward(h0) == forward(h1))
+                oAdjacency.FlippedEdges++;
+        }
+        else
+        {
+            oAdjacency.NonManifoldEdges++;
+        }
+
+        i = end;
+    }
+
+    oAdjacency.DegenerateEdges = (unsigned int)(n - i);
+}
+
+// Build the half-edge adjacency of a newMesh
+void BuildAdjacency(Adjacency& oAdjacency, const newMesh& mesh, const AdjacencyOptions& options)
+{
+    // newMeshes kept as polygons are triangulated first
+    TriangulateOptions triangulate;
+    triangulate.MaxThreads = options.MaxThreads;
+    std::vector<unsigned int> triangulated;
+
+    BuildAdjacency(oAdjacency, mesh.Vertices, TriangleIndices(mesh, triangulated, triangulate), options);
+}
+
+// Build the adjacency of every loaded newMesh
+void BuildAdjacency(std::vector<Adjacency>& oAdjacency, const Loader& loader, const AdjacencyOptions& options)
+{
+    const std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    oAdjacency.clear();
+    oAdjacency.resize(meshes.size());
+
+    // With enough newMeshes to keep every thread busy build one
+    //	newMesh per thread, otherwise give all threads to each sort
+    if (meshes.size() >= WorkerCount(options.MaxThreads))
+    {
+        AdjacencyOptions single = options;
+        single.MaxThreads = 1;
+
+        ParallelFor(meshes.size(), [&](size_t i)
+        {
+            BuildAdjacency(oAdjacency[i], meshes[i], single);
+        }, options.MaxThreads);
+    }
+    else
+    {
+        for (size_t i = 0; i < meshes.size(); i++)
+            BuildAdjacency(oAdjacency[i], meshes[i], options);
+    }
+}
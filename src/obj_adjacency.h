@@ -0,0 +1,99 @@
+#ifndef OBJ_ADJACENCY_H
+#define OBJ_ADJACENCY_H
+
+#include <obj_loader.h>
+
+// Marks a half-edge without a twin
+#define OBJL_NO_TWIN 0xffffffffu
+
+// Structure: Adjacency
+// Description: Half-edge connectivity of a triangle list
+//
+// Half-edge h runs from corner h to the next corner of triangle
+// h / 3, so half-edges share their numbering with the index list.
+struct Adjacency
+{
+    Adjacency()
+    {
+        PositionCount = 0;
+        Edges = 0;
+        BoundaryEdges = 0;
+        NonManifoldEdges = 0;
+        FlippedEdges = 0;
+        DegenerateEdges = 0;
+    }
+
+    // Opposite half-edge of every half-edge, OBJL_NO_TWIN on
+    //	boundary, degenerate and non-manifold edges
+    std::vector<unsigned int> Twin;
+    // Welded position id of every vertex
+    std::vector<unsigned int> PositionRemap;
+    // Number of distinct positions
+    unsigned int PositionCount;
+
+    // Distinct undirected edges
+    unsigned int Edges;
+    // Edges used by a single triangle
+    unsigned int BoundaryEdges;
+    // Edges shared by more than two triangles
+    unsigned int NonManifoldEdges;
+    // Edges shared by two triangles that run the same way along it
+    unsigned int FlippedEdges;
+    // Half-edges whose two ends weld to the same position
+    unsigned int DegenerateEdges;
+
+    // Triangle of a half-edge
+    static unsigned int Face(unsigned int h) { return h / 3; }
+    // Next half-edge around the triangle
+    static unsigned int Next(unsigned int h) { return h % 3 == 2 ? h - 2 : h + 1; }
+    // Previous half-edge around the triangle
+    static unsigned int Prev(unsigned int h) { return h % 3 == 0 ? h + 2 : h - 1; }
+
+    // Every edge is shared by at most two triangles
+    bool IsManifold() const { return NonManifoldEdges == 0; }
+    // Manifold and without boundary
+    bool IsClosed() const { return NonManifoldEdges == 0 && BoundaryEdges == 0; }
+    // Manifold and every pair of neighbours agrees on the winding
+    bool IsOriented() const { return NonManifoldEdges == 0 && FlippedEdges == 0; }
+};
+
+// Structure: AdjacencyOptions
+// Description: Settings for building adjacency
+struct AdjacencyOptions
+{
+    AdjacencyOptions()
+    {
+        WeldPositions = true;
+        MaxThreads = 0;
+    }
+
+    // Join vertices with equal positions before matching edges,
+    //	the loader writes one vertex per face corner so without
+    //	this every edge of a loaded newMesh is a boundary
+    bool WeldPositions;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Build the half-edge adjacency of an index list
+//
+// Every half-edge gets a 64 bit key made of its two welded end
+// points, the keys are radix sorted in parallel and runs of equal
+// keys are matched into twins and counted for the statistics.
+void BuildAdjacency(Adjacency& oAdjacency,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    const AdjacencyOptions& options = AdjacencyOptions());
+
+// Build the half-edge adjacency of a newMesh
+//
+// A newMesh kept as polygons (KeepPolygons) is triangulated first, its
+// half-edges then follow the corners of TriangleIndices(mesh).
+void BuildAdjacency(Adjacency& oAdjacency, const newMesh& mesh, const AdjacencyOptions& options = AdjacencyOptions());
+
+// Build the adjacency of every loaded newMesh
+//
+// oAdjacency gets one entry per loaded newMesh
+void BuildAdjacency(std::vector<Adjacency>& oAdjacency, const Loader& loader, const AdjacencyOptions& options = AdjacencyOptions());
+
+#endif
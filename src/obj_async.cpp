@@ -0,0 +1,88 @@
+// obj_async.cpp - Background loading with progress, cancellation and mesh streaming
+
+#include <obj_async.h>
+
+#include <chrono>
+
+LoadTask::LoadTask(bool streamMeshes)
+    : streamMeshes(streamMeshes), cancelled(false), phase(LoadPhase::Queued), bytesParsed(0), bytesTotal(0)
+{
+}
+
+LoadTask::~LoadTask()
+{
+    Cancel();
+    if (result.valid())
+        result.wait();
+}
+
+// Wait for the load to end
+bool LoadTask::Wait()
+{
+    return result.valid() && result.get();
+}
+
+// Check if the load has ended
+bool LoadTask::Ready() const
+{
+    return !result.valid() || result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Ask the load to stop, it does so at the next line
+void LoadTask::Cancel()
+{
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+// Take the next finished newMesh
+bool LoadTask::PopnewMesh(newMesh& oMesh)
+{
+    std::lock_guard<std::mutex> lock(meshLock);
+    if (meshes.empty())
+        return false;
+    oMesh = std::move(meshes.front());
+    meshes.pop_front();
+    return true;
+}
+
+// Hand out a finished newMesh
+void LoadTask::PushnewMesh(newMesh&& mesh)
+{
+    std::lock_guard<std::mutex> lock(meshLock);
+    meshes.push_back(std::move(mesh));
+}
+
+// Load a file into the loader on a background thread
+std::shared_ptr<LoadTask> Loader::LoadFileAsync(std::string Path, bool streamMeshes)
+{
+    std::shared_ptr<LoadTask> task = std::make_shared<LoadTask>(streamMeshes);
+    LoadTask* t = task.get();
+
+    task->result = std::async(std::launch::async, [this, t, Path]()
+    {
+        Task = t;
+        t->SetPhase(LoadPhase::Parsing);
+
+        bool loaded;
+        try
+        {
+            loaded = LoadFile(Path);
+        }
+        catch (...)
+        {
+            // The loader must not keep a task that may be gone
+            Task = nullptr;
+            t->SetPhase(LoadPhase::Failed);
+            throw;
+        }
+
+        Task = nullptr;
+        if (t->Cancelled())
+            t->SetPhase(LoadPhase::Cancelled);
+        else
+            t->SetPhase(loaded ? LoadPhase::Done : LoadPhase::Failed);
+        return loaded && !t->Cancelled();
+    }).share();
+
+    return task;
+}
@@ -0,0 +1,90 @@
+#ifndef OBJ_ASYNC_H
+#define OBJ_ASYNC_H
+
+#include <obj_loader.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+
+// Enum: LoadPhase
+// Description: What an asynchronous load is doing
+enum class LoadPhase
+{
+    Queued,
+    Parsing,
+    Materials,
+    Finishing,
+    Done,
+    Cancelled,
+    Failed
+};
+
+// Class: LoadTask
+// Description: Handle of a load running in the background
+//
+// The Loader that started the task must outlive it and must not
+// be used until the task is Ready. Destroying the handle cancels
+// the load and waits for it to stop.
+class LoadTask
+{
+public:
+    LoadTask(bool streamMeshes);
+    ~LoadTask();
+
+    // Wait for the load to end
+    //
+    // Returns true if the file was loaded, an exception thrown
+    // by the load (malformed numbers) is thrown again from here
+    bool Wait();
+
+    // Check if the load has ended
+    bool Ready() const;
+
+    // Ask the load to stop, it does so at the next line
+    void Cancel();
+
+    // Check if Cancel was called
+    bool Cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    // Current Phase
+    LoadPhase Phase() const { return phase.load(); }
+
+    // Bytes of the file parsed so far
+    uint64_t BytesParsed() const { return bytesParsed.load(std::memory_order_relaxed); }
+    // Size of the file in bytes, 0 while unknown (compressed files)
+    uint64_t BytesTotal() const { return bytesTotal.load(std::memory_order_relaxed); }
+
+    // Take the next finished newMesh
+    //
+    // Only filled when the task was started with streamMeshes,
+    // returns false if no newMesh is waiting
+    bool PopnewMesh(newMesh& oMesh);
+
+    // Check if finished newMeshes are handed out
+    bool StreamMeshes() const { return streamMeshes; }
+
+    // Called by the loader while it runs
+    void SetPhase(LoadPhase p) { phase.store(p); }
+    void SetBytesParsed(uint64_t bytes) { bytesParsed.store(bytes, std::memory_order_relaxed); }
+    void SetBytesTotal(uint64_t bytes) { bytesTotal.store(bytes, std::memory_order_relaxed); }
+    void PushnewMesh(newMesh&& mesh);
+
+private:
+    friend class Loader;
+
+    bool streamMeshes;
+    std::atomic<bool> cancelled;
+    std::atomic<LoadPhase> phase;
+    std::atomic<uint64_t> bytesParsed;
+    std::atomic<uint64_t> bytesTotal;
+
+    std::shared_future<bool> result;
+
+    std::mutex meshLock;
+    std::deque<newMesh> meshes;
+};
+
+#endif
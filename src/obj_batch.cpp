@@ -0,0 +1,162 @@
+// obj_batch.cpp - Merging newMeshes by material into draw ranges
+
+#include <obj_batch.h>
+#include <obj_parallel.h>
+#include <obj_polygon.h>
+
+#include <unordered_map>
+
+// Vertices a 16 bit range can use, 0xFFFF is left free as the
+//	primitive restart index of GL, Vulkan and glTF
+static const uint32_t kShortRangeVertices = 65535;
+
+// Vertex not in the current range yet
+static const uint32_t kNone = 0xffffffffu;
+
+// Merge the newMeshes of one material into ranges of at most maxVertices
+static void BatchMaterial(BatchedModel& oPart, const std::vector<newMesh>& meshes,
+    const std::vector<size_t>& group, unsigned int materialIndex, uint32_t maxVertices, bool colored)
+{
+    DrawRange range;
+    range.MaterialIndex = materialIndex;
+
+    // Range local index of every vertex of the current newMesh,
+    //	stamp tells which range set it
+    std::vector<uint32_t> local, stamp;
+    uint32_t rangeId = 0;
+
+    // newMeshes kept as polygons are triangulated here, on this thread
+    TriangulateOptions triangulate;
+    triangulate.MaxThreads = 1;
+    std::vector<unsigned int> triangulated;
+
+    auto close = [&]()
+    {
+        if (range.IndexCount == 0)
+            return;
+        range.RangeBounds.Finish();
+        oPart.Ranges.push_back(range);
+
+        range = DrawRange();
+        range.MaterialIndex = materialIndex;
+        range.FirstIndex = (uint32_t)oPart.Indices.size();
+        range.BaseVertex = (uint32_t)oPart.Vertices.size();
+        rangeId++;
+    };
+
+    for (size_t m : group)
+    {
+        const newMesh& mesh = meshes[m];
+        const std::vector<unsigned int>& indices = TriangleIndices(mesh, triangulated, triangulate);
+        local.assign(mesh.Vertices.size(), 0);
+        stamp.assign(mesh.Vertices.size(), kNone);
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            // Start a new range when this triangle would not fit
+            uint32_t added = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned int v = indices[t + c];
+                if (stamp[v] != rangeId)
+                    added++;
+            }
+            if (range.VertexCount + added > maxVertices)
+                close();
+
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned int v = indices[t + c];
+                if (stamp[v] != rangeId)
+                {
+                    stamp[v] = rangeId;
+                    local[v] = range.VertexCount++;
+                    oPart.Vertices.push_back(mesh.Vertices[v]);
+                    if (colored)
+                        oPart.Colors.push_back(mesh.Colors.empty() ? glm::vec3(1.0f) : mesh.Colors[v]);
+                    range.RangeBounds.Add(mesh.Vertices[v].Position);
+                }
+                oPart.Indices.push_back(local[v]);
+            }
+            range.IndexCount += 3;
+        }
+    }
+    close();
+}
+
+// Merge the loaded newMeshes by material into draw ranges
+void BatchByMaterial(BatchedModel& oModel, const Loader& loader, const BatchOptions& options)
+{
+    const std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    oModel = BatchedModel();
+
+    // Group the newMeshes by usemtl name, in order of first use
+    std::unordered_map<std::string, unsigned int> materialIds;
+    std::vector<std::vector<size_t>> groups;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const std::string& name = i < loader.LoadedMaterialNames.size()
+            ? loader.LoadedMaterialNames[i] : meshes[i].GetMaterial().name;
+
+        auto found = materialIds.emplace(name, (unsigned int)groups.size());
+        if (found.second)
+        {
+            groups.emplace_back();
+            oModel.Materials.push_back(meshes[i].GetMaterial());
+            oModel.Materials.back().name = name;
+        }
+        groups[found.first->second].push_back(i);
+    }
+
+    uint32_t maxVertices = options.ShortIndices ? kShortRangeVertices : kNone;
+
+    bool colored = false;
+    for (const newMesh& mesh : meshes)
+        colored = colored || !mesh.Colors.empty();
+
+    std::vector<BatchedModel> parts(groups.size());
+    ParallelFor(groups.size(), [&](size_t g)
+    {
+        BatchMaterial(parts[g], meshes, groups[g], (unsigned int)g, maxVertices, colored);
+    }, options.MaxThreads);
+
+    // Put the parts one after another
+    size_t vertexCount = 0, indexCount = 0, rangeCount = 0;
+    for (const BatchedModel& part : parts)
+    {
+        vertexCount += part.Vertices.size();
+        indexCount += part.Indices.size();
+        rangeCount += part.Ranges.size();
+    }
+
+    oModel.Vertices.reserve(vertexCount);
+    if (colored)
+        oModel.Colors.reserve(vertexCount);
+    oModel.Ranges.reserve(rangeCount);
+    if (options.ShortIndices)
+        oModel.Indices16.reserve(indexCount);
+    else
+        oModel.Indices.reserve(indexCount);
+
+    for (BatchedModel& part : parts)
+    {
+        uint32_t baseVertex = (uint32_t)oModel.Vertices.size();
+        uint32_t firstIndex = (uint32_t)(options.ShortIndices ? oModel.Indices16.size() : oModel.Indices.size());
+
+        for (DrawRange range : part.Ranges)
+        {
+            range.BaseVertex += baseVertex;
+            range.FirstIndex += firstIndex;
+            oModel.Ranges.push_back(range);
+        }
+
+        oModel.Vertices.insert(oModel.Vertices.end(), part.Vertices.begin(), part.Vertices.end());
+        oModel.Colors.insert(oModel.Colors.end(), part.Colors.begin(), part.Colors.end());
+        if (options.ShortIndices)
+            oModel.Indices16.insert(oModel.Indices16.end(), part.Indices.begin(), part.Indices.end());
+        else
+            oModel.Indices.insert(oModel.Indices.end(), part.Indices.begin(), part.Indices.end());
+
+        part = BatchedModel();
+    }
+}
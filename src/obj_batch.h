@@ -0,0 +1,76 @@
+#ifndef OBJ_BATCH_H
+#define OBJ_BATCH_H
+
+#include <obj_loader.h>
+
+#include <cstdint>
+
+// Structure: DrawRange
+// Description: One draw call of a BatchedModel
+//
+// Indices of the range are relative to BaseVertex, as taken by
+// glDrawElementsBaseVertex / vkCmdDrawIndexed.
+struct DrawRange
+{
+    // Index into BatchedModel::Materials
+    unsigned int MaterialIndex = 0;
+    // First index in Indices / Indices16
+    uint32_t FirstIndex = 0;
+    // Number of indices
+    uint32_t IndexCount = 0;
+    // First vertex in Vertices
+    uint32_t BaseVertex = 0;
+    // Number of vertices the range uses, from BaseVertex
+    uint32_t VertexCount = 0;
+    // Bounding Box and Sphere
+    Bounds RangeBounds;
+};
+
+// Structure: BatchOptions
+// Description: Settings for batching newMeshes into draw ranges
+struct BatchOptions
+{
+    BatchOptions()
+    {
+        ShortIndices = false;
+        MaxThreads = 0;
+    }
+
+    // Split ranges at 65535 vertices and fill Indices16
+    //	instead of Indices
+    bool ShortIndices;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Structure: BatchedModel
+// Description: A model as one vertex and index buffer plus a draw range table
+struct BatchedModel
+{
+    // Vertices of all ranges, each range in one block
+    std::vector<Vertex> Vertices;
+    // Color of every vertex, filled when any batched newMesh has
+    //	vertex colors (white for the others)
+    std::vector<glm::vec3> Colors;
+    // 32 bit indices, relative to the BaseVertex of their range
+    std::vector<uint32_t> Indices;
+    // 16 bit indices, filled instead of Indices with ShortIndices
+    std::vector<uint16_t> Indices16;
+    // Draw ranges, grouped by material in the order the
+    //	materials are first used
+    std::vector<DrawRange> Ranges;
+    // One material per usemtl name
+    std::vector<Material> Materials;
+};
+
+// Merge the loaded newMeshes by material into draw ranges
+//
+// Every newMesh with the same usemtl name goes into one range (several
+// with ShortIndices), so the model draws in one call per material.
+// Only vertices the indices use are kept, newMeshes kept as polygons
+// (KeepPolygons) are triangulated. Materials are batched in parallel.
+// Only triangles are batched, lines and points (LineIndices,
+// PointIndices) are left out.
+void BatchByMaterial(BatchedModel& oModel, const Loader& loader, const BatchOptions& options = BatchOptions());
+
+#endif
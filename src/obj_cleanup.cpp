@@ -0,0 +1,370 @@
+// obj_cleanup.cpp - Epsilon welding through a spatial hash grid and removal of bad triangles
+
+#include <obj_cleanup.h>
+#include <obj_parallel.h>
+#include <obj_remap.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// No cluster or vertex
+static const unsigned int kNone = 0xffffffffu;
+
+// Largest grid cell coordinate, far positions share the outer cells
+static const float kMaxCell = 1e9f;
+
+// Add the counts of another cleanup
+void CleanupStats::Add(const CleanupStats& s)
+{
+    VerticesBefore += s.VerticesBefore;
+    VerticesAfter += s.VerticesAfter;
+    TrianglesBefore += s.TrianglesBefore;
+    TrianglesAfter += s.TrianglesAfter;
+    SnappedPositions += s.SnappedPositions;
+    DegenerateTriangles += s.DegenerateTriangles;
+    DuplicateTriangles += s.DuplicateTriangles;
+}
+
+// Grid cell of a coordinate
+static int32_t Cell(float v, float inverseSize)
+{
+    float c = std::floor(v * inverseSize);
+    // Written so NaN lands in a cell too
+    if (!(c >= -kMaxCell))
+        c = -kMaxCell;
+    if (c > kMaxCell)
+        c = kMaxCell;
+    return (int32_t)c;
+}
+
+// Hash of a grid cell
+static uint32_t HashCell(int32_t x, int32_t y, int32_t z)
+{
+    return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+}
+
+// Give every vertex a cluster of positions at most distance apart
+//
+// oFirst gets the first vertex of every cluster, its position is
+// the position of the cluster
+static void ClusterPositions(std::vector<unsigned int>& oCluster, std::vector<unsigned int>& oFirst,
+    const std::vector<Vertex>& verts, float distance)
+{
+    if (distance <= 0.0f)
+    {
+        BuildRemap(oCluster, oFirst, verts, [](const Vertex& v) -> const glm::vec3& { return v.Position; });
+        return;
+    }
+
+    size_t tableSize = 1;
+    while (tableSize < verts.size() * 2)
+        tableSize *= 2;
+
+    // Every slot chains the clusters whose first position
+    //	has a cell hashing to it
+    std::vector<unsigned int> head(tableSize, kNone);
+    std::vector<unsigned int> next;
+
+    const float inverseSize = 1.0f / distance;
+    const float distance2 = distance * distance;
+
+    oCluster.resize(verts.size());
+    oFirst.clear();
+
+    for (size_t i = 0; i < verts.size(); i++)
+    {
+        const glm::vec3& p = verts[i].Position;
+        int32_t cx = Cell(p.x, inverseSize), cy = Cell(p.y, inverseSize), cz = Cell(p.z, inverseSize);
+
+        // Positions within distance are at most one cell away
+        unsigned int found = kNone;
+        for (int dz = -1; dz <= 1 && found == kNone; dz++)
+        {
+            for (int dy = -1; dy <= 1 && found == kNone; dy++)
+            {
+                for (int dx = -1; dx <= 1 && found == kNone; dx++)
+                {
+                    size_t slot = HashCell(cx + dx, cy + dy, cz + dz) & (tableSize - 1);
+                    for (unsigned int c = head[slot]; c != kNone; c = next[c])
+                    {
+                        glm::vec3 d = verts[oFirst[c]].Position - p;
+                        if (DotV3(d, d) <= distance2)
+                        {
+                            found = c;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (found == kNone)
+        {
+            found = (unsigned int)oFirst.size();
+            size_t slot = HashCell(cx, cy, cz) & (tableSize - 1);
+            oFirst.push_back((unsigned int)i);
+            next.push_back(head[slot]);
+            head[slot] = found;
+        }
+        oCluster[i] = found;
+    }
+}
+
+// Check if two vertices on one position may merge
+static bool SameAttributes(const Vertex& a, const Vertex& b, float tolerance)
+{
+    glm::vec3 n = a.Normal - b.Normal;
+    glm::vec2 t = a.TextureCoordinate - b.TextureCoordinate;
+    return std::fabs(n.x) <= tolerance && std::fabs(n.y) <= tolerance && std::fabs(n.z) <= tolerance
+        && std::fabs(t.x) <= tolerance && std::fabs(t.y) <= tolerance;
+}
+
+// Drop the bad triangles of an index list
+static void FilterTriangles(std::vector<unsigned int>& indices, const std::vector<Vertex>& verts,
+    const std::vector<unsigned int>& cluster, const CleanupOptions& options, CleanupStats& stats, bool count)
+{
+    size_t triangles = indices.size() / 3;
+    std::vector<unsigned int> kept;
+    kept.reserve(triangles * 3);
+
+    std::vector<std::array<unsigned int, 3>> keys;
+    keys.reserve(triangles);
+
+    size_t degenerate = 0;
+    for (size_t t = 0; t < triangles; t++)
+    {
+        unsigned int a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+        unsigned int ca = cluster[a], cb = cluster[b], cc = cluster[c];
+
+        if (options.RemoveDegenerate)
+        {
+            bool bad = ca == cb || cb == cc || cc == ca;
+            if (!bad)
+            {
+                // Height over the longest edge is twice the area over it
+                glm::vec3 pa = verts[a].Position, pb = verts[b].Position, pc = verts[c].Position;
+                float area2 = MagnitudeV3(CrossV3(pb - pa, pc - pa));
+                float longest = std::max(MagnitudeV3(pb - pa), std::max(MagnitudeV3(pc - pb), MagnitudeV3(pa - pc)));
+                bad = !(area2 > options.WeldDistance * longest);
+            }
+            if (bad)
+            {
+                degenerate++;
+                continue;
+            }
+        }
+
+        // The same corners in the same winding, whichever comes first
+        std::array<unsigned int, 3> key = { ca, cb, cc };
+        if (cb < ca && cb < cc)
+            key = { cb, cc, ca };
+        else if (cc < ca && cc < cb)
+            key = { cc, ca, cb };
+        keys.push_back(key);
+
+        kept.push_back(a);
+        kept.push_back(b);
+        kept.push_back(c);
+    }
+
+    size_t duplicate = 0;
+    if (options.RemoveDuplicates && !keys.empty())
+    {
+        std::vector<unsigned int> remap, first;
+        BuildRemap(remap, first, keys, [](const std::array<unsigned int, 3>& k) -> const std::array<unsigned int, 3>& { return k; });
+
+        size_t out = 0;
+        for (size_t t = 0; t < keys.size(); t++)
+        {
+            if (first[remap[t]] != t)
+                continue;
+            for (int c = 0; c < 3; c++)
+                kept[3 * out + c] = kept[3 * t + c];
+            out++;
+        }
+        duplicate = keys.size() - out;
+        kept.resize(3 * out);
+    }
+
+    if (count)
+    {
+        stats.TrianglesBefore += triangles;
+        stats.TrianglesAfter += kept.size() / 3;
+        stats.DegenerateTriangles += degenerate;
+        stats.DuplicateTriangles += duplicate;
+    }
+    indices.swap(kept);
+}
+
+// Weld the vertices of a newMesh and drop its bad triangles
+CleanupStats Cleanup(newMesh& mesh, const CleanupOptions& options)
+{
+    CleanupStats stats;
+    const std::vector<Vertex>& verts = mesh.Vertices;
+    stats.VerticesBefore = verts.size();
+
+    std::vector<unsigned int> cluster, first;
+    ClusterPositions(cluster, first, verts, options.WeldDistance);
+
+    // Merge the vertices of every cluster that share attributes,
+    //	clusterHead/nextMerged chain the merged vertices of a cluster
+    std::vector<Vertex> merged;
+    std::vector<unsigned int> mergedCluster, nextMerged;
+    std::vector<unsigned int> clusterHead(first.size(), kNone);
+    std::vector<unsigned int> remap(verts.size());
+
+    // Vertex colors take part like the other attributes
+    const std::vector<glm::vec3>& colors = mesh.Colors;
+    bool colored = colors.size() == verts.size();
+    std::vector<glm::vec3> mergedColors;
+
+    auto sameColor = [&](unsigned int m, size_t i)
+    {
+        glm::vec3 d = mergedColors[m] - colors[i];
+        return std::fabs(d.x) <= options.AttributeTolerance && std::fabs(d.y) <= options.AttributeTolerance
+            && std::fabs(d.z) <= options.AttributeTolerance;
+    };
+
+    for (size_t i = 0; i < verts.size(); i++)
+    {
+        unsigned int c = cluster[i];
+        const glm::vec3& p = verts[first[c]].Position;
+        if (memcmp(&p, &verts[i].Position, sizeof(p)) != 0)
+            stats.SnappedPositions++;
+
+        unsigned int m = clusterHead[c];
+        while (m != kNone && !options.IgnoreAttributes
+            && !(SameAttributes(merged[m], verts[i], options.AttributeTolerance) && (!colored || sameColor(m, i))))
+            m = nextMerged[m];
+
+        if (m == kNone)
+        {
+            m = (unsigned int)merged.size();
+            merged.push_back(verts[i]);
+            merged.back().Position = p;
+            if (colored)
+                mergedColors.push_back(colors[i]);
+            mergedCluster.push_back(c);
+            nextMerged.push_back(kNone);
+
+            // Append, so the first vertex of a cluster is found first
+            if (clusterHead[c] == kNone)
+            {
+                clusterHead[c] = m;
+            }
+            else
+            {
+                unsigned int last = clusterHead[c];
+                while (nextMerged[last] != kNone)
+                    last = nextMerged[last];
+                nextMerged[last] = m;
+            }
+        }
+        remap[i] = m;
+    }
+
+    // Remap and filter every index list
+    for (unsigned int& index : mesh.Indices)
+        index = remap[index];
+    FilterTriangles(mesh.Indices, merged, mergedCluster, options, stats, true);
+
+    for (std::vector<unsigned int>& lod : mesh.LODIndices)
+    {
+        for (unsigned int& index : lod)
+            index = remap[index];
+        FilterTriangles(lod, merged, mergedCluster, options, stats, false);
+    }
+
+    // Faces kept as polygons, lines and points are welded but not filtered
+    std::vector<unsigned int>* elements[] = { &mesh.FaceCorners, &mesh.LineIndices, &mesh.PointIndices };
+    for (std::vector<unsigned int>* list : elements)
+    {
+        for (unsigned int& index : *list)
+            index = remap[index];
+    }
+
+    // Keep the vertices still used, in their order
+    std::vector<unsigned int> used(merged.size(), kNone);
+    for (unsigned int index : mesh.Indices)
+        used[index] = 0;
+    for (const std::vector<unsigned int>& lod : mesh.LODIndices)
+    {
+        for (unsigned int index : lod)
+            used[index] = 0;
+    }
+    for (std::vector<unsigned int>* list : elements)
+    {
+        for (unsigned int index : *list)
+            used[index] = 0;
+    }
+
+    std::vector<Vertex> kept;
+    std::vector<glm::vec3> keptColors;
+    for (size_t i = 0; i < merged.size(); i++)
+    {
+        if (used[i] == kNone)
+            continue;
+        used[i] = (unsigned int)kept.size();
+        kept.push_back(merged[i]);
+        if (colored)
+            keptColors.push_back(mergedColors[i]);
+    }
+
+    for (unsigned int& index : mesh.Indices)
+        index = used[index];
+    for (std::vector<unsigned int>& lod : mesh.LODIndices)
+    {
+        for (unsigned int& index : lod)
+            index = used[index];
+    }
+    for (std::vector<unsigned int>* list : elements)
+    {
+        for (unsigned int& index : *list)
+            index = used[index];
+    }
+
+    mesh.Vertices.swap(kept);
+    if (colored)
+        mesh.Colors.swap(keptColors);
+    stats.VerticesAfter = mesh.Vertices.size();
+
+    mesh.newMeshBounds.Reset();
+    for (const Vertex& v : mesh.Vertices)
+        mesh.newMeshBounds.Add(v.Position);
+    mesh.newMeshBounds.Finish(mesh.Vertices);
+
+    return stats;
+}
+
+// Clean every loaded newMesh, in parallel
+CleanupStats Cleanup(Loader& loader, const CleanupOptions& options)
+{
+    std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    bool gathered = loader.GatheredLoadednewMeshes();
+
+    // Welding a newMesh is sequential, so every thread takes whole newMeshes
+    std::vector<CleanupStats> meshStats(meshes.size());
+    ParallelFor(meshes.size(), [&](size_t i)
+    {
+        meshStats[i] = Cleanup(meshes[i], options);
+    }, options.MaxThreads);
+
+    CleanupStats stats;
+    for (const CleanupStats& s : meshStats)
+        stats.Add(s);
+
+    if (gathered)
+    {
+        loader.GatherLoadednewMeshes();
+
+        loader.LoadedBounds.Reset();
+        for (const newMesh& mesh : meshes)
+            loader.LoadedBounds.Add(mesh.newMeshBounds);
+        loader.LoadedBounds.Finish();
+    }
+
+    return stats;
+}
@@ -0,0 +1,73 @@
+#ifndef OBJ_CLEANUP_H
+#define OBJ_CLEANUP_H
+
+#include <obj_loader.h>
+
+// Structure: CleanupOptions
+// Description: Settings for welding and degenerate triangle removal
+struct CleanupOptions
+{
+    CleanupOptions()
+    {
+        WeldDistance = 1e-5f;
+        AttributeTolerance = 1e-3f;
+        IgnoreAttributes = false;
+        RemoveDegenerate = true;
+        RemoveDuplicates = true;
+        MaxThreads = 0;
+    }
+
+    // Positions at most this far apart are welded into one,
+    //	0 welds only equal positions
+    float WeldDistance;
+    // Vertices on a welded position merge when their normals and
+    //	texture coordinates differ by at most this (per component)
+    float AttributeTolerance;
+    // Merge all vertices on a welded position, keeping the
+    //	normal and texture coordinate of the first
+    bool IgnoreAttributes;
+    // Drop triangles with less than WeldDistance height
+    bool RemoveDegenerate;
+    // Drop triangles with the same welded corners (and winding)
+    //	as an earlier triangle
+    bool RemoveDuplicates;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Structure: CleanupStats
+// Description: What a cleanup removed
+struct CleanupStats
+{
+    // Vertices before and after
+    size_t VerticesBefore = 0;
+    size_t VerticesAfter = 0;
+    // Triangles before and after
+    size_t TrianglesBefore = 0;
+    size_t TrianglesAfter = 0;
+    // Vertices moved onto a close position
+    size_t SnappedPositions = 0;
+    // Triangles dropped for being degenerate
+    size_t DegenerateTriangles = 0;
+    // Triangles dropped for repeating another
+    size_t DuplicateTriangles = 0;
+
+    // Add the counts of another cleanup
+    void Add(const CleanupStats& s);
+};
+
+// Weld the vertices of a newMesh and drop its bad triangles
+//
+// Positions are clustered through a spatial hash grid with cells
+// of WeldDistance, every position moves onto the first one of its
+// cluster, so later stages can compare positions exactly. The LOD
+// index lists are cleaned too, unused vertices are removed and the
+// bounds recomputed.
+CleanupStats Cleanup(newMesh& mesh, const CleanupOptions& options = CleanupOptions());
+
+// Clean every loaded newMesh, in parallel
+//
+// LoadedVertices, LoadedIndices and LoadedBounds are rebuilt to match
+CleanupStats Cleanup(Loader& loader, const CleanupOptions& options = CleanupOptions());
+
+#endif
@@ -0,0 +1,392 @@
+// obj_gltf.cpp - Binary glTF (.glb) output
+
+#include <obj_gltf.h>
+#include <obj_mtlcache.h>
+#include <obj_polygon.h>
+#include <obj_texture.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+// glTF Constants
+static const int kFloat = 5126;
+static const int kUnsignedInt = 5125;
+static const int kUnsignedShort = 5123;
+static const int kArrayBuffer = 34962;
+static const int kElementArrayBuffer = 34963;
+static const int kPoints = 0;
+static const int kLines = 1;
+static const int kTriangles = 4;
+
+// Quote and escape a string for JSON
+static std::string JsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Format a float for JSON
+static std::string JsonFloat(float v)
+{
+    if (!(v == v) || v > FLT_MAX || v < -FLT_MAX)
+        return "0";
+    char buf[32];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+}
+
+// Format a double for JSON
+static std::string JsonDouble(double v)
+{
+    if (!(v == v) || v > DBL_MAX || v < -DBL_MAX)
+        return "0";
+    char buf[32];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+}
+
+// Format a vec3 as a JSON array
+static std::string JsonVec3(const glm::vec3& v)
+{
+    return "[" + JsonFloat(v.x) + "," + JsonFloat(v.y) + "," + JsonFloat(v.z) + "]";
+}
+
+// Join JSON values into an array
+static std::string JsonArray(const std::vector<std::string>& items)
+{
+    std::string out = "[";
+    for (size_t i = 0; i < items.size(); i++)
+        out += (i ? "," : "") + items[i];
+    return out + "]";
+}
+
+// Turn a texture path into a relative URI
+static std::string TextureURI(const std::string& path)
+{
+    std::string uri;
+    for (char c : path)
+    {
+        if (c == '\\')
+            uri += '/';
+        else if (c == ' ')
+            uri += "%20";
+        else
+            uri += c;
+    }
+    return uri;
+}
+
+// Write the vertices of a newMesh and track the position bounds
+//
+// pos/nrm/uv point at the first element of each attribute,
+// the strides are the distances between two elements in bytes.
+// oNormals tells if every vertex had a normal.
+static void PackVertices(const std::vector<Vertex>& verts,
+    unsigned char* pos, unsigned char* nrm, unsigned char* uv,
+    size_t posStride, size_t nrmStride, size_t uvStride,
+    glm::vec3& oMin, glm::vec3& oMax, bool& oNormals)
+{
+    oMin = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    oMax = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    oNormals = true;
+
+    for (size_t i = 0; i < verts.size(); i++)
+    {
+        const Vertex& v = verts[i];
+
+        // glTF wants unit normals, face normals from the loader are not
+        glm::vec3 n = v.Normal;
+        float len = MagnitudeV3(n);
+        if (len > 0)
+        {
+            n = n / len;
+        }
+        else
+        {
+            // Only line and point vertices have none, glTF still wants
+            //	every element of a NORMAL accessor unit length
+            n = glm::vec3(0.0f, 0.0f, 1.0f);
+            oNormals = false;
+        }
+
+        memcpy(pos + i * posStride, &v.Position, sizeof(glm::vec3));
+        memcpy(nrm + i * nrmStride, &n, sizeof(glm::vec3));
+        memcpy(uv + i * uvStride, &v.TextureCoordinate, sizeof(glm::vec2));
+
+        oMin = glm::min(oMin, v.Position);
+        oMax = glm::max(oMax, v.Position);
+    }
+}
+
+// Write newMeshes and their materials to a binary glTF (.glb) file
+bool WriteGLB(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const GLBOptions& options)
+{
+    std::vector<unsigned char> bin;
+    std::vector<std::string> views, accessors, gltfMeshes, nodes, gltfMaterials, textures, images;
+
+    // Rebased positions are placed back at their origin by every node
+    std::string translation;
+    if (options.Origin != glm::dvec3(0.0))
+    {
+        translation = ",\"translation\":[" + JsonDouble(options.Origin.x) + ","
+            + JsonDouble(options.Origin.y) + "," + JsonDouble(options.Origin.z) + "]";
+    }
+
+    auto alignBin = [&]()
+    {
+        while (bin.size() % 4)
+            bin.push_back(0);
+    };
+
+    auto addView = [&](size_t offset, size_t length, size_t stride, int target)
+    {
+        std::string v = "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset)
+            + ",\"byteLength\":" + std::to_string(length);
+        if (stride)
+            v += ",\"byteStride\":" + std::to_string(stride);
+        v += ",\"target\":" + std::to_string(target) + "}";
+        views.push_back(v);
+        return views.size() - 1;
+    };
+
+    auto addAccessor = [&](size_t view, size_t offset, int componentType, size_t count, const char* type, const std::string& extra)
+    {
+        accessors.push_back("{\"bufferView\":" + std::to_string(view)
+            + ",\"byteOffset\":" + std::to_string(offset)
+            + ",\"componentType\":" + std::to_string(componentType)
+            + ",\"count\":" + std::to_string(count)
+            + ",\"type\":\"" + type + "\"" + extra + "}");
+        return accessors.size() - 1;
+    };
+
+    // Materials
+    std::map<std::string, size_t> imageIndex;
+    auto addTexture = [&](const std::string& path)
+    {
+        auto found = imageIndex.find(path);
+        if (found == imageIndex.end())
+        {
+            images.push_back("{\"uri\":" + JsonString(TextureURI(path)) + "}");
+            textures.push_back("{\"sampler\":0,\"source\":" + std::to_string(images.size() - 1) + "}");
+            found = imageIndex.insert({ path, textures.size() - 1 }).first;
+        }
+        return found->second;
+    };
+
+    for (const Material& m : materials)
+    {
+        // An unset dissolve loads as 0, treat it as opaque
+        float alpha = m.d > 0 ? m.d : 1.0f;
+        // Blinn-Phong exponent to GGX roughness
+        float roughness = sqrtf(2.0f / (std::max(m.Ns, 0.0f) + 2.0f));
+
+        std::string json = "{\"name\":" + JsonString(m.name)
+            + ",\"pbrMetallicRoughness\":{\"baseColorFactor\":["
+            + JsonFloat(m.Kd.x) + "," + JsonFloat(m.Kd.y) + "," + JsonFloat(m.Kd.z) + "," + JsonFloat(alpha) + "]"
+            + ",\"metallicFactor\":0,\"roughnessFactor\":" + JsonFloat(roughness);
+        // Map statements may carry options before the file name
+        std::string baseColor = MapFileName(m.map_Kd), bump = MapFileName(m.map_bump);
+        if (!baseColor.empty())
+            json += ",\"baseColorTexture\":{\"index\":" + std::to_string(addTexture(baseColor)) + "}";
+        json += "}";
+        if (!bump.empty())
+            json += ",\"normalTexture\":{\"index\":" + std::to_string(addTexture(bump)) + "}";
+        if (alpha < 1.0f)
+            json += ",\"alphaMode\":\"BLEND\"";
+        json += "}";
+        gltfMaterials.push_back(json);
+    }
+
+    // newMeshes, those kept as polygons are triangulated here
+    std::vector<unsigned int> triangulated;
+    for (const newMesh& mesh : meshes)
+    {
+        const std::vector<unsigned int>& indices = TriangleIndices(mesh, triangulated);
+        size_t vertexCount = mesh.Vertices.size();
+        if (vertexCount == 0 || (indices.empty() && mesh.LineIndices.empty() && mesh.PointIndices.empty()))
+            continue;
+
+        glm::vec3 minP, maxP;
+        bool normals;
+        size_t posAccessor, nrmAccessor, uvAccessor;
+
+        // Position, normal and texture coordinate take 32 bytes a vertex
+        alignBin();
+        size_t start = bin.size();
+        bin.resize(start + vertexCount * 32);
+
+        if (options.Interleaved)
+        {
+            const size_t stride = 32;
+            unsigned char* base = &bin[start];
+            PackVertices(mesh.Vertices, base, base + 12, base + 24, stride, stride, stride, minP, maxP, normals);
+
+            size_t view = addView(start, vertexCount * stride, stride, kArrayBuffer);
+            posAccessor = addAccessor(view, 0, kFloat, vertexCount, "VEC3", ",\"min\":" + JsonVec3(minP) + ",\"max\":" + JsonVec3(maxP));
+            nrmAccessor = addAccessor(view, 12, kFloat, vertexCount, "VEC3", "");
+            uvAccessor = addAccessor(view, 24, kFloat, vertexCount, "VEC2", "");
+        }
+        else
+        {
+            size_t nrmStart = start + vertexCount * 12;
+            size_t uvStart = nrmStart + vertexCount * 12;
+            PackVertices(mesh.Vertices, &bin[start], &bin[nrmStart], &bin[uvStart], 12, 12, 8, minP, maxP, normals);
+
+            posAccessor = addAccessor(addView(start, vertexCount * 12, 0, kArrayBuffer), 0, kFloat, vertexCount, "VEC3",
+                ",\"min\":" + JsonVec3(minP) + ",\"max\":" + JsonVec3(maxP));
+            nrmAccessor = addAccessor(addView(nrmStart, vertexCount * 12, 0, kArrayBuffer), 0, kFloat, vertexCount, "VEC3", "");
+            uvAccessor = addAccessor(addView(uvStart, vertexCount * 8, 0, kArrayBuffer), 0, kFloat, vertexCount, "VEC2", "");
+        }
+
+        // Lines and points leave NORMAL out unless every vertex has one
+        std::string attributes = "{\"POSITION\":" + std::to_string(posAccessor)
+            + ",\"TEXCOORD_0\":" + std::to_string(uvAccessor);
+        std::string normal = ",\"NORMAL\":" + std::to_string(nrmAccessor);
+
+        // Vertex colors in a view of their own, in either layout
+        if (mesh.Colors.size() == vertexCount)
+        {
+            size_t colorStart = bin.size();
+            bin.resize(colorStart + vertexCount * 12);
+            memcpy(&bin[colorStart], mesh.Colors.data(), vertexCount * 12);
+            attributes += ",\"COLOR_0\":" + std::to_string(addAccessor(addView(colorStart, vertexCount * 12, 0, kArrayBuffer),
+                0, kFloat, vertexCount, "VEC3", ""));
+        }
+        std::string lineAttributes = attributes + (normals ? normal : "") + "}";
+        attributes += normal + "}";
+
+        std::string material;
+        for (size_t m = 0; m < materials.size(); m++)
+        {
+            if (!mesh.GetMaterial().name.empty() && materials[m].name == mesh.GetMaterial().name)
+            {
+                material = ",\"material\":" + std::to_string(m);
+                break;
+            }
+        }
+
+        // One primitive for each of triangles, lines and points, all
+        //	sharing the vertex attributes
+        bool shortIndices = options.ShortIndices && vertexCount < 65536;
+        size_t indexSize = shortIndices ? 2 : 4;
+        std::vector<std::string> primitives;
+        auto addPrimitive = [&](const std::vector<unsigned int>& list, int mode)
+        {
+            if (list.empty())
+                return;
+
+            size_t indexStart = bin.size();
+            bin.resize(indexStart + list.size() * indexSize);
+
+            if (shortIndices)
+            {
+                for (size_t i = 0; i < list.size(); i++)
+                {
+                    uint16_t v = (uint16_t)list[i];
+                    memcpy(&bin[indexStart + i * 2], &v, 2);
+                }
+            }
+            else
+            {
+                memcpy(&bin[indexStart], list.data(), list.size() * 4);
+            }
+            alignBin();
+
+            size_t indexAccessor = addAccessor(addView(indexStart, list.size() * indexSize, 0, kElementArrayBuffer),
+                0, shortIndices ? kUnsignedShort : kUnsignedInt, list.size(), "SCALAR", "");
+
+            primitives.push_back("{\"attributes\":" + (mode == kTriangles ? attributes : lineAttributes)
+                + ",\"indices\":" + std::to_string(indexAccessor) + ",\"mode\":" + std::to_string(mode) + material + "}");
+        };
+        addPrimitive(indices, kTriangles);
+        addPrimitive(mesh.LineIndices, kLines);
+        addPrimitive(mesh.PointIndices, kPoints);
+
+        gltfMeshes.push_back("{\"name\":" + JsonString(mesh.newMeshName) + ",\"primitives\":" + JsonArray(primitives) + "}");
+        nodes.push_back("{\"name\":" + JsonString(mesh.newMeshName) + ",\"mesh\":" + std::to_string(gltfMeshes.size() - 1) + translation + "}");
+    }
+    alignBin();
+
+    // JSON chunk
+    std::vector<std::string> sceneNodes;
+    for (size_t i = 0; i < nodes.size(); i++)
+        sceneNodes.push_back(std::to_string(i));
+
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"OBJ Loader\"}";
+    json += ",\"scene\":0,\"scenes\":[{\"nodes\":" + JsonArray(sceneNodes) + "}]";
+
+    const std::pair<const char*, const std::vector<std::string>*> arrays[] = {
+        { "nodes", &nodes }, { "meshes", &gltfMeshes }, { "materials", &gltfMaterials },
+        { "textures", &textures }, { "images", &images },
+        { "accessors", &accessors }, { "bufferViews", &views } };
+    for (const auto& a : arrays)
+    {
+        if (!a.second->empty())
+            json += ",\"" + std::string(a.first) + "\":" + JsonArray(*a.second);
+    }
+    if (!textures.empty())
+        json += ",\"samplers\":[{}]";
+    if (!bin.empty())
+        json += ",\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}]";
+    json += "}";
+
+    while (json.size() % 4)
+        json += ' ';
+
+    // GLB container
+    std::ofstream file(Path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    uint32_t header[3] = { 0x46546C67, 2, (uint32_t)(12 + 8 + json.size() + (bin.empty() ? 0 : 8 + bin.size())) };
+    uint32_t jsonChunk[2] = { (uint32_t)json.size(), 0x4E4F534A };
+    file.write((const char*)header, sizeof(header));
+    file.write((const char*)jsonChunk, sizeof(jsonChunk));
+    file.write(json.data(), json.size());
+
+    if (!bin.empty())
+    {
+        uint32_t binChunk[2] = { (uint32_t)bin.size(), 0x004E4942 };
+        file.write((const char*)binChunk, sizeof(binChunk));
+        file.write((const char*)bin.data(), bin.size());
+    }
+
+    return bool(file);
+}
+
+// Write the loaded newMeshes and materials of a loader to a .glb file
+bool WriteGLB(const std::string& Path, const Loader& loader, const GLBOptions& options)
+{
+    GLBOptions rebased = options;
+    rebased.Origin = loader.LoadedOrigin;
+
+    // Materials are copied for writing only when the load did not
+    std::vector<Material> collected;
+    const std::vector<Material>& materials = loader.CopyMaterials
+        ? loader.LoadedMaterials : (collected = CollectMaterials(loader.LoadedLibraries));
+    return WriteGLB(Path, loader.LoadednewMeshes, materials, rebased);
+}
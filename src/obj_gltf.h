@@ -0,0 +1,47 @@
+#ifndef OBJ_GLTF_H
+#define OBJ_GLTF_H
+
+#include <obj_loader.h>
+
+// Structure: GLBOptions
+// Description: Settings for writing binary glTF
+struct GLBOptions
+{
+    GLBOptions()
+    {
+        Interleaved = true;
+        ShortIndices = true;
+        Origin = glm::dvec3(0.0);
+    }
+
+    // One interleaved buffer view per newMesh (position, normal,
+    //	texture coordinate), otherwise one buffer view per attribute
+    bool Interleaved;
+    // Write 16 bit indices for newMeshes with at most 65535 vertices,
+    //	65535 itself is the primitive restart index
+    bool ShortIndices;
+    // Translation of every node, to place positions rebased by
+    //	Loader::RebasePositions (the Loader overload uses LoadedOrigin)
+    glm::dvec3 Origin;
+};
+
+// Write newMeshes and their materials to a binary glTF (.glb) file
+//
+// Vertices are written straight into the binary chunk in a
+// single pass that also computes the position bounds. Materials
+// become metallic-roughness materials: Kd and d give the base
+// color, Ns the roughness, map_Kd the base color texture and
+// map_bump the normal texture (referenced by file name without
+// map options, not embedded). newMeshes kept as polygons
+// (KeepPolygons) are triangulated. Vertex colors become COLOR_0,
+// lines and points LINES and POINTS primitives next to the
+// triangles, without NORMAL when some vertex has no normal.
+bool WriteGLB(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const GLBOptions& options = GLBOptions());
+
+// Write the loaded newMeshes and materials of a loader to a .glb file
+bool WriteGLB(const std::string& Path, const Loader& loader, const GLBOptions& options = GLBOptions());
+
+#endif
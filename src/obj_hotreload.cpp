@@ -0,0 +1,318 @@
+// obj_hotreload.cpp - Watching .obj/.mtl files and publishing reloaded snapshots
+
+#include <obj_hotreload.h>
+#include <obj_index.h>
+#include <obj_mtlcache.h>
+
+#include <chrono>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Get the directory part of a path
+static std::string DirectoryOf(const std::string& Path)
+{
+    size_t slash = Path.find_last_of('/');
+    if (slash == std::string::npos)
+        return ".";
+    return slash == 0 ? "/" : Path.substr(0, slash);
+}
+
+HotReloader::HotReloader()
+    : version(0), objSize(0), objTime(0), stopping(false), notifyFd(-1)
+{
+    stopPipe[0] = stopPipe[1] = -1;
+}
+
+HotReloader::~HotReloader()
+{
+    Stop();
+}
+
+// Load a file and start watching it
+bool HotReloader::Watch(const std::string& Path, const HotReloadOptions& opts)
+{
+    Stop();
+
+    path = Path;
+    options = opts;
+    if (!ReloadGeometry())
+        return false;
+
+#ifdef __linux__
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd >= 0 && pipe2(stopPipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        close(notifyFd);
+        notifyFd = -1;
+    }
+    if (notifyFd >= 0)
+        WatchDirectories();
+#endif
+
+    stopping = false;
+    worker = std::thread(&HotReloader::Run, this);
+    return true;
+}
+
+// Stop watching
+void HotReloader::Stop()
+{
+    if (!worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        stopping = true;
+    }
+    wake.notify_all();
+#ifdef __linux__
+    if (stopPipe[1] >= 0)
+    {
+        char c = 0;
+        (void)!write(stopPipe[1], &c, 1);
+    }
+#endif
+
+    worker.join();
+
+#ifdef __linux__
+    for (int fd : { notifyFd, stopPipe[0], stopPipe[1] })
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+    notifyFd = stopPipe[0] = stopPipe[1] = -1;
+}
+
+// Get the current snapshot
+std::shared_ptr<const ModelSnapshot> HotReloader::Snapshot() const
+{
+    return std::atomic_load(&current);
+}
+
+// Get the counters
+HotReloadStats HotReloader::Stats() const
+{
+    std::lock_guard<std::mutex> lock(statsLock);
+    return stats;
+}
+
+// Load the .obj into a new snapshot
+bool HotReloader::ReloadGeometry()
+{
+    // Stamp before reading, a write during the load is seen next time
+    uint64_t size;
+    int64_t time;
+    if (!FileStamp(path, size, time))
+        return false;
+
+    Loader loader;
+    loader.RebasePositions = options.RebasePositions;
+    if (!loader.LoadFile(path))
+    {
+        std::lock_guard<std::mutex> lock(statsLock);
+        stats.Failures++;
+        return false;
+    }
+
+    std::shared_ptr<ModelGeometry> geometry = std::make_shared<ModelGeometry>();
+    geometry->Meshes = std::move(loader.LoadednewMeshes);
+    geometry->MaterialNames = std::move(loader.LoadedMaterialNames);
+    geometry->ModelBounds = loader.LoadedBounds;
+    geometry->Origin = loader.LoadedOrigin;
+
+    std::shared_ptr<ModelSnapshot> snapshot = std::make_shared<ModelSnapshot>();
+    snapshot->Libraries = std::move(loader.LoadedLibraries);
+    for (const newMesh& mesh : geometry->Meshes)
+        snapshot->MeshMaterials.push_back(mesh.SharedMaterial);
+    snapshot->Geometry = geometry;
+
+    objSize = size;
+    objTime = time;
+    Publish(snapshot);
+    return true;
+}
+
+// Rebind the materials of the current geometry into a new snapshot
+bool HotReloader::ReloadMaterials()
+{
+    std::shared_ptr<const ModelSnapshot> last = Snapshot();
+    std::shared_ptr<ModelSnapshot> snapshot = std::make_shared<ModelSnapshot>();
+    snapshot->Geometry = last->Geometry;
+
+    // The cache parses the libraries that changed again
+    std::unordered_map<std::string, std::shared_ptr<const Material>> materialIndex;
+    for (const auto& old : last->Libraries)
+    {
+        std::shared_ptr<const MaterialLibrary> library = GetMaterialLibrary(old->Path);
+        if (!library)
+        {
+            std::lock_guard<std::mutex> lock(statsLock);
+            stats.Failures++;
+            return false;
+        }
+
+        snapshot->Libraries.push_back(library);
+        for (const Material& m : library->Materials)
+            materialIndex.emplace(m.name, std::shared_ptr<const Material>(library, &m));
+    }
+
+    const ModelGeometry& geometry = *snapshot->Geometry;
+    snapshot->MeshMaterials.resize(geometry.Meshes.size());
+    for (size_t i = 0; i < geometry.Meshes.size(); i++)
+    {
+        auto it = materialIndex.find(geometry.MaterialNames[i]);
+        if (it != materialIndex.end())
+            snapshot->MeshMaterials[i] = it->second;
+    }
+
+    Publish(snapshot);
+    return true;
+}
+
+// Publish a snapshot and remember the stamps of its files
+void HotReloader::Publish(std::shared_ptr<ModelSnapshot> snapshot)
+{
+    snapshot->Version = ++version;
+
+    libraryStamps.clear();
+    for (const auto& library : snapshot->Libraries)
+    {
+        std::pair<uint64_t, int64_t> stamp(0, 0);
+        FileStamp(library->Path, stamp.first, stamp.second);
+        libraryStamps.push_back(stamp);
+    }
+
+    std::atomic_store(&current, std::shared_ptr<const ModelSnapshot>(std::move(snapshot)));
+}
+
+// Reload whatever changed since the last snapshot
+void HotReloader::Check()
+{
+    uint64_t size;
+    int64_t time;
+
+    // A file being replaced may be missing for a moment
+    if (!FileStamp(path, size, time))
+        return;
+
+    bool reloaded = false;
+
+    // A malformed or half written file throws from the parser, the
+    //	last good snapshot stays published and the next change retries
+    try
+    {
+        if (size != objSize || time != objTime)
+        {
+            reloaded = ReloadGeometry();
+            if (reloaded)
+            {
+                std::lock_guard<std::mutex> lock(statsLock);
+                stats.GeometryReloads++;
+            }
+
+            // The .obj may name new libraries
+            if (reloaded && notifyFd >= 0)
+                WatchDirectories();
+        }
+        else
+        {
+            std::shared_ptr<const ModelSnapshot> last = Snapshot();
+            bool changed = false;
+            for (size_t i = 0; i < last->Libraries.size() && !changed; i++)
+            {
+                if (!FileStamp(last->Libraries[i]->Path, size, time))
+                    return;
+                changed = libraryStamps[i] != std::make_pair(size, time);
+            }
+
+            if (changed)
+            {
+                reloaded = ReloadMaterials();
+                if (reloaded)
+                {
+                    std::lock_guard<std::mutex> lock(statsLock);
+                    stats.MaterialReloads++;
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        reloaded = false;
+        std::lock_guard<std::mutex> lock(statsLock);
+        stats.Failures++;
+    }
+
+    if (reloaded && OnReload)
+        OnReload(Snapshot());
+}
+
+// Add the directories of the current files to the watch
+void HotReloader::WatchDirectories()
+{
+#ifdef __linux__
+    // Editors and exporters often replace files by renaming,
+    //	so the directories are watched rather than the files
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB;
+
+    inotify_add_watch(notifyFd, DirectoryOf(path).c_str(), mask);
+    for (const auto& library : Snapshot()->Libraries)
+        inotify_add_watch(notifyFd, DirectoryOf(library->Path).c_str(), mask);
+#endif
+}
+
+// Block until a watched directory changes, or for a while
+void HotReloader::WaitForChange()
+{
+#ifdef __linux__
+    if (notifyFd >= 0)
+    {
+        // Read and drop pending events, only the stamps matter
+        auto drain = [&]()
+        {
+            alignas(inotify_event) char buffer[4096];
+            while (read(notifyFd, buffer, sizeof(buffer)) > 0)
+            {
+            }
+        };
+
+        pollfd fds[2] = { { notifyFd, POLLIN, 0 }, { stopPipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+            return;
+        drain();
+
+        // Wait for the writes to settle
+        while (!stopping)
+        {
+            fds[0].revents = fds[1].revents = 0;
+            if (poll(fds, 2, (int)options.DebounceMs) <= 0 || (fds[1].revents & POLLIN))
+                return;
+            drain();
+        }
+        return;
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(wakeLock);
+    wake.wait_for(lock, std::chrono::milliseconds(options.PollMs), [&]() { return stopping.load(); });
+}
+
+// Body of the watching thread
+void HotReloader::Run()
+{
+    while (!stopping)
+    {
+        WaitForChange();
+        if (stopping)
+            break;
+        Check();
+    }
+}
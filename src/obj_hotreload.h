@@ -0,0 +1,149 @@
+#ifndef OBJ_HOTRELOAD_H
+#define OBJ_HOTRELOAD_H
+
+#include <obj_loader.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Structure: ModelGeometry
+// Description: The parsed geometry of a model, shared by every snapshot until the .obj changes
+struct ModelGeometry
+{
+    // Loaded newMeshes, SharedMaterial is the material at the
+    //	time the geometry was loaded, see ModelSnapshot::MeshMaterials
+    std::vector<newMesh> Meshes;
+    // Material name (usemtl) of every newMesh
+    std::vector<std::string> MaterialNames;
+    // Bounding Box and Sphere of all newMeshes
+    Bounds ModelBounds;
+    // Origin of the positions (Loader::RebasePositions)
+    glm::dvec3 Origin;
+};
+
+// Structure: ModelSnapshot
+// Description: One immutable state of a watched model
+struct ModelSnapshot
+{
+    // Geometry, the same object across material only reloads
+    std::shared_ptr<const ModelGeometry> Geometry;
+    // Current material of every newMesh, nullptr when no library
+    //	has its name, shared with Libraries rather than copied
+    std::vector<std::shared_ptr<const Material>> MeshMaterials;
+    // Libraries the materials come from
+    std::vector<std::shared_ptr<const MaterialLibrary>> Libraries;
+    // Increases with every published snapshot, starting at 1
+    uint64_t Version;
+};
+
+// Structure: HotReloadOptions
+// Description: Settings for watching a model
+struct HotReloadOptions
+{
+    HotReloadOptions()
+    {
+        RebasePositions = false;
+        DebounceMs = 50;
+        PollMs = 250;
+    }
+
+    // Load with Loader::RebasePositions
+    bool RebasePositions;
+    // Quiet time after the last file event before reloading,
+    //	exporters write files in several steps
+    unsigned int DebounceMs;
+    // Time between checks where inotify is not available
+    unsigned int PollMs;
+};
+
+// Structure: HotReloadStats
+// Description: Counters of a hot reloader
+struct HotReloadStats
+{
+    // Reloads of the .obj (geometry and materials)
+    uint64_t GeometryReloads = 0;
+    // Reloads of .mtl files alone (materials rebound)
+    uint64_t MaterialReloads = 0;
+    // Reloads that failed and kept the previous snapshot
+    uint64_t Failures = 0;
+};
+
+// Class: HotReloader
+// Description: Watches an .obj and its .mtl files and publishes a new snapshot when they change
+//
+// The directories of the files are watched with inotify (polled
+// elsewhere) on a thread of their own. A changed .obj is loaded
+// again, a change to only .mtl files rebinds the materials and
+// keeps the geometry. Snapshots are published atomically, readers
+// take the current one with Snapshot() and keep it as long as they
+// like without ever waiting for a reload.
+class HotReloader
+{
+public:
+    HotReloader();
+    ~HotReloader();
+
+    // Load a file and start watching it
+    //
+    // Returns false if the first load fails
+    bool Watch(const std::string& Path, const HotReloadOptions& options = HotReloadOptions());
+
+    // Stop watching, the last snapshot stays available
+    void Stop();
+
+    // Get the current snapshot, nullptr before the first load
+    std::shared_ptr<const ModelSnapshot> Snapshot() const;
+
+    // Get the counters
+    HotReloadStats Stats() const;
+
+    // Called on the watching thread after every published reload
+    //
+    // Set before Watch
+    std::function<void(const std::shared_ptr<const ModelSnapshot>&)> OnReload;
+
+private:
+    // Load the .obj into a new snapshot
+    bool ReloadGeometry();
+    // Rebind the materials of the current geometry into a new snapshot
+    bool ReloadMaterials();
+    // Publish a snapshot and remember the stamps of its files
+    void Publish(std::shared_ptr<ModelSnapshot> snapshot);
+    // Reload whatever changed since the last snapshot
+    void Check();
+    // Block until a watched directory changes, or for a while
+    void WaitForChange();
+    // Add the directories of the current files to the watch
+    void WatchDirectories();
+    // Body of the watching thread
+    void Run();
+
+    std::string path;
+    HotReloadOptions options;
+
+    std::shared_ptr<const ModelSnapshot> current;
+    uint64_t version;
+
+    // Size and time of the .obj and of every library when last read
+    uint64_t objSize;
+    int64_t objTime;
+    std::vector<std::pair<uint64_t, int64_t>> libraryStamps;
+
+    mutable std::mutex statsLock;
+    HotReloadStats stats;
+
+    std::thread worker;
+    std::atomic<bool> stopping;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+
+    // inotify descriptor and the pipe that interrupts it, -1 when unused
+    int notifyFd;
+    int stopPipe[2];
+};
+
+#endif
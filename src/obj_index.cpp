@@ -0,0 +1,461 @@
+// obj_index.cpp - Byte offset index and selective loading of objects/groups
+
+#include <obj_index.h>
+#include <obj_stream.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+
+// Identifies an index file and its layout version
+static const char kIndexMagic[8] = { 'O', 'B', 'J', 'L', 'I', 'D', 'X', '1' };
+
+// Remove a trailing carriage return (files with CRLF line endings)
+static void StripCR(std::string& line)
+{
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+}
+
+// Get the size and modification time of a file
+bool FileStamp(const std::string& Path, uint64_t& oSize, int64_t& oTime)
+{
+    std::error_code ec;
+    oSize = std::filesystem::file_size(Path, ec);
+    if (ec)
+        return false;
+    oTime = (int64_t)std::filesystem::last_write_time(Path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+// Count an attribute element, starting a new chunk every OBJL_INDEX_CHUNK elements
+static void AddChunkElement(std::vector<OBJIndexChunk>& chunks, unsigned int& count, uint64_t begin, uint64_t end)
+{
+    if (count % OBJL_INDEX_CHUNK == 0)
+        chunks.push_back({ begin, end });
+    chunks.back().End = end;
+    count++;
+}
+
+// Get the path the index of an .obj file is stored at
+std::string OBJIndexPath(const std::string& Path)
+{
+    return Path + ".idx";
+}
+
+// Scan an .obj file and record its boundaries and attribute ranges
+bool BuildOBJIndex(const std::string& Path, OBJIndex& oIndex)
+{
+    oIndex = OBJIndex();
+
+    if (!FileStamp(Path, oIndex.FileSize, oIndex.FileTime))
+        return false;
+
+    std::ifstream file(Path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    uint64_t offset = 0;
+    std::string curline;
+    while (std::getline(file, curline))
+    {
+        uint64_t begin = offset;
+        offset += curline.size() + 1;
+        StripCR(curline);
+
+        std::string token = firstToken(curline);
+        if (token.empty())
+            continue;
+
+        if (token == "v")
+        {
+            AddChunkElement(oIndex.PositionChunks, oIndex.PositionCount, begin, offset);
+        }
+        else if (token == "vt")
+        {
+            AddChunkElement(oIndex.TCoordChunks, oIndex.TCoordCount, begin, offset);
+        }
+        else if (token == "vn")
+        {
+            AddChunkElement(oIndex.NormalChunks, oIndex.NormalCount, begin, offset);
+        }
+        else if (token == "o" || token == "g" || token == "usemtl")
+        {
+            OBJIndexBlock block;
+            block.Type = token == "usemtl" ? 'u' : token[0];
+            block.Name = tail(curline);
+            block.Offset = begin;
+            block.PositionBase = oIndex.PositionCount;
+            block.TCoordBase = oIndex.TCoordCount;
+            block.NormalBase = oIndex.NormalCount;
+            oIndex.Blocks.push_back(block);
+        }
+        else if (token == "mtllib")
+        {
+            oIndex.MaterialLibraries.push_back(tail(curline));
+        }
+    }
+
+    // The last line may have no line break
+    for (std::vector<OBJIndexChunk>* chunks : { &oIndex.PositionChunks, &oIndex.TCoordChunks, &oIndex.NormalChunks })
+    {
+        if (!chunks->empty())
+            chunks->back().End = std::min(chunks->back().End, oIndex.FileSize);
+    }
+
+    return true;
+}
+
+// Binary Writers
+static void WriteU64(std::ostream& out, uint64_t v)
+{
+    out.write((const char*)&v, sizeof(v));
+}
+
+static void WriteString(std::ostream& out, const std::string& s)
+{
+    WriteU64(out, s.size());
+    out.write(s.data(), s.size());
+}
+
+static void WriteChunks(std::ostream& out, const std::vector<OBJIndexChunk>& chunks)
+{
+    WriteU64(out, chunks.size());
+    for (const OBJIndexChunk& c : chunks)
+    {
+        WriteU64(out, c.Begin);
+        WriteU64(out, c.End);
+    }
+}
+
+// Binary Readers
+static bool ReadU64(std::istream& in, uint64_t& v)
+{
+    return bool(in.read((char*)&v, sizeof(v)));
+}
+
+static bool ReadString(std::istream& in, std::string& s)
+{
+    uint64_t size;
+    if (!ReadU64(in, size) || size > (1u << 20))
+        return false;
+    s.resize(size);
+    return bool(in.read(&s[0], size));
+}
+
+static bool ReadChunks(std::istream& in, std::vector<OBJIndexChunk>& chunks)
+{
+    uint64_t count;
+    if (!ReadU64(in, count) || count > (1ull << 32))
+        return false;
+    chunks.resize(count);
+    for (OBJIndexChunk& c : chunks)
+    {
+        if (!ReadU64(in, c.Begin) || !ReadU64(in, c.End))
+            return false;
+    }
+    return true;
+}
+
+// Write an index to disk
+bool SaveOBJIndex(const std::string& indexPath, const OBJIndex& index)
+{
+    std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    out.write(kIndexMagic, sizeof(kIndexMagic));
+    WriteU64(out, index.FileSize);
+    WriteU64(out, (uint64_t)index.FileTime);
+    WriteU64(out, index.PositionCount);
+    WriteU64(out, index.TCoordCount);
+    WriteU64(out, index.NormalCount);
+
+    WriteU64(out, index.MaterialLibraries.size());
+    for (const std::string& lib : index.MaterialLibraries)
+        WriteString(out, lib);
+
+    WriteU64(out, index.Blocks.size());
+    for (const OBJIndexBlock& b : index.Blocks)
+    {
+        WriteU64(out, (uint64_t)b.Type);
+        WriteString(out, b.Name);
+        WriteU64(out, b.Offset);
+        WriteU64(out, b.PositionBase);
+        WriteU64(out, b.TCoordBase);
+        WriteU64(out, b.NormalBase);
+    }
+
+    WriteChunks(out, index.PositionChunks);
+    WriteChunks(out, index.TCoordChunks);
+    WriteChunks(out, index.NormalChunks);
+
+    return bool(out);
+}
+
+// Read an index from disk
+bool LoadOBJIndex(const std::string& indexPath, const std::string& Path, OBJIndex& oIndex)
+{
+    std::ifstream in(indexPath, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    char magic[sizeof(kIndexMagic)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kIndexMagic))
+        return false;
+
+    oIndex = OBJIndex();
+
+    uint64_t time, pcount, tcount, ncount, count;
+    if (!ReadU64(in, oIndex.FileSize) || !ReadU64(in, time)
+        || !ReadU64(in, pcount) || !ReadU64(in, tcount) || !ReadU64(in, ncount))
+        return false;
+    oIndex.FileTime = (int64_t)time;
+    oIndex.PositionCount = (unsigned int)pcount;
+    oIndex.TCoordCount = (unsigned int)tcount;
+    oIndex.NormalCount = (unsigned int)ncount;
+
+    // Stale if the .obj changed since it was indexed
+    uint64_t size;
+    int64_t stamp;
+    if (!FileStamp(Path, size, stamp) || stamp != oIndex.FileTime || size != oIndex.FileSize)
+        return false;
+
+    if (!ReadU64(in, count) || count > (1u << 20))
+        return false;
+    oIndex.MaterialLibraries.resize(count);
+    for (std::string& lib : oIndex.MaterialLibraries)
+    {
+        if (!ReadString(in, lib))
+            return false;
+    }
+
+    if (!ReadU64(in, count) || count > (1ull << 32))
+        return false;
+    oIndex.Blocks.resize(count);
+    for (OBJIndexBlock& b : oIndex.Blocks)
+    {
+        uint64_t type, pbase, tbase, nbase;
+        if (!ReadU64(in, type) || !ReadString(in, b.Name) || !ReadU64(in, b.Offset)
+            || !ReadU64(in, pbase) || !ReadU64(in, tbase) || !ReadU64(in, nbase))
+            return false;
+        b.Type = (char)type;
+        b.PositionBase = (unsigned int)pbase;
+        b.TCoordBase = (unsigned int)tbase;
+        b.NormalBase = (unsigned int)nbase;
+    }
+
+    return ReadChunks(in, oIndex.PositionChunks)
+        && ReadChunks(in, oIndex.TCoordChunks)
+        && ReadChunks(in, oIndex.NormalChunks);
+}
+
+// Get the index of an .obj file
+bool GetOBJIndex(const std::string& Path, OBJIndex& oIndex)
+{
+    std::string indexPath = OBJIndexPath(Path);
+
+    if (LoadOBJIndex(indexPath, Path, oIndex))
+        return true;
+
+    if (!BuildOBJIndex(Path, oIndex))
+        return false;
+
+    // Not being able to store the index only costs the next load a scan
+    SaveOBJIndex(indexPath, oIndex);
+    return true;
+}
+
+// Read a byte range of a file
+static bool ReadRange(std::ifstream& file, uint64_t begin, uint64_t end, std::string& oText)
+{
+    oText.resize(end - begin);
+    file.clear();
+    file.seekg(begin);
+    return bool(file.read(&oText[0], oText.size()));
+}
+
+// Parse the v/vt/vn lines of the flagged chunks into a full size attribute list
+//
+// With an origin the values are parsed as double and stored relative to it
+template <class T, int N>
+static bool ReadAttributeChunks(std::ifstream& file, const std::vector<OBJIndexChunk>& chunks,
+    const std::vector<char>& wanted, const std::string& token, std::vector<T>& oAttributes,
+    const double* origin = nullptr)
+{
+    std::string text, curline;
+    std::vector<std::string> values;
+
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        if (!wanted[c])
+            continue;
+        if (!ReadRange(file, chunks[c].Begin, chunks[c].End, text))
+            return false;
+
+        size_t element = c * OBJL_INDEX_CHUNK;
+        std::istringstream lines(text);
+        while (std::getline(lines, curline) && element < oAttributes.size())
+        {
+            StripCR(curline);
+            if (firstToken(curline) != token)
+                continue;
+
+            split(tail(curline), values, " ");
+            T& a = oAttributes[element++];
+            for (int k = 0; k < N && k < int(values.size()); k++)
+                a[k] = origin ? std::stod(values[k]) - origin[k] : std::stof(values[k]);
+        }
+    }
+    return true;
+}
+
+// Load only the named objects/groups of a file
+bool Loader::LoadGroups(std::string Path, const std::vector<std::string>& Names)
+{
+    // Byte offsets need a file that can be read at random
+    if (IsCompressedOBJ(Path))
+        return false;
+
+    OBJIndex index;
+    if (!GetOBJIndex(Path, index))
+        return false;
+
+    std::ifstream file(Path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    LoadednewMeshes.clear();
+    LoadedVertices.clear();
+    LoadedIndices.clear();
+
+    std::vector<char> wantedPositions(index.PositionChunks.size(), 0);
+    std::vector<char> wantedTCoords(index.TCoordChunks.size(), 0);
+    std::vector<char> wantedNormals(index.NormalChunks.size(), 0);
+
+    // Collect the selected blocks into one stream of lines,
+    //	with the faces rewritten to absolute indices
+    std::string selected;
+    for (const std::string& lib : index.MaterialLibraries)
+        selected += "mtllib " + lib + "\n";
+
+    std::string text, curline;
+    std::vector<std::string> sface, svert;
+
+    for (size_t b = 0; b < index.Blocks.size(); b++)
+    {
+        const OBJIndexBlock& block = index.Blocks[b];
+        if (block.Type == 'u' || std::find(Names.begin(), Names.end(), block.Name) == Names.end())
+            continue;
+
+        // An object runs until the next object, a group until the next object or group
+        uint64_t end = index.FileSize;
+        for (size_t n = b + 1; n < index.Blocks.size(); n++)
+        {
+            char type = index.Blocks[n].Type;
+            if (type == 'o' || (type == 'g' && block.Type == 'g'))
+            {
+                end = index.Blocks[n].Offset;
+                break;
+            }
+        }
+
+        // Material in use when the block starts, it applies
+        //	unless the block picks its own before the first face
+        std::string material;
+        for (size_t m = b; m-- > 0;)
+        {
+            if (index.Blocks[m].Type == 'u')
+            {
+                material = "usemtl " + index.Blocks[m].Name + "\n";
+                break;
+            }
+        }
+
+        if (!ReadRange(file, block.Offset, end, text))
+            return false;
+
+        unsigned int counts[3] = { block.PositionBase, block.TCoordBase, block.NormalBase };
+        unsigned int totals[3] = { index.PositionCount, index.TCoordCount, index.NormalCount };
+        std::vector<char>* wanted[3] = { &wantedPositions, &wantedTCoords, &wantedNormals };
+
+        std::istringstream lines(text);
+        while (std::getline(lines, curline))
+        {
+            StripCR(curline);
+            std::string token = firstToken(curline);
+
+            // Attributes come from the chunks, only count them
+            if (token == "v" || token == "vt" || token == "vn")
+            {
+                counts[token == "v" ? 0 : (token == "vt" ? 1 : 2)]++;
+                continue;
+            }
+            if (token == "mtllib")
+                continue;
+            if (token == "usemtl")
+                material.clear();
+            // Faces, lines and points index the attributes
+            if (token != "f" && token != "l" && token != "p")
+            {
+                selected += curline + "\n";
+                continue;
+            }
+
+            selected += material;
+            material.clear();
+
+            std::string element = token;
+            split(tail(curline), sface, " ");
+            for (const std::string& corner : sface)
+            {
+                if (corner.empty())
+                    continue;
+
+                split(corner, svert, "/");
+                element += " ";
+                for (int k = 0; k < int(svert.size()) && k < 3; k++)
+                {
+                    if (k > 0)
+                        element += "/";
+                    if (svert[k].empty())
+                        continue;
+
+                    long idx = std::stol(svert[k]);
+                    long absolute = idx < 0 ? long(counts[k]) + idx + 1 : idx;
+                    if (absolute >= 1 && absolute <= long(totals[k]))
+                        (*wanted[k])[(absolute - 1) / OBJL_INDEX_CHUNK] = 1;
+                    element += std::to_string(absolute);
+                }
+            }
+            selected += element + "\n";
+        }
+    }
+
+    // Parse only the attribute chunks the faces use
+    std::vector<glm::vec3> Positions(index.PositionCount);
+    std::vector<glm::vec2> TCoords(index.TCoordCount);
+    std::vector<glm::vec3> Normals(index.NormalCount);
+
+    // The origin is the first position of the file, as in LoadFile
+    LoadedOrigin = glm::dvec3(0.0);
+    if (RebasePositions && !Positions.empty())
+    {
+        const double zero[3] = { 0.0, 0.0, 0.0 };
+        std::vector<glm::dvec3> first(1);
+        if (!ReadAttributeChunks<glm::dvec3, 3>(file, { index.PositionChunks[0] }, { 1 }, "v", first, zero))
+            return false;
+        LoadedOrigin = first[0];
+    }
+
+    if (!ReadAttributeChunks<glm::vec3, 3>(file, index.PositionChunks, wantedPositions, "v", Positions,
+            RebasePositions ? &LoadedOrigin.x : nullptr)
+        || !ReadAttributeChunks<glm::vec2, 2>(file, index.TCoordChunks, wantedTCoords, "vt", TCoords)
+        || !ReadAttributeChunks<glm::vec3, 3>(file, index.NormalChunks, wantedNormals, "vn", Normals))
+        return false;
+
+    file.close();
+
+    std::istringstream stream(selected);
+    return ParseOBJ(stream, Path, Positions, TCoords, Normals);
+}
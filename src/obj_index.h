@@ -0,0 +1,85 @@
+#ifndef OBJ_INDEX_H
+#define OBJ_INDEX_H
+
+#include <obj_loader.h>
+
+#include <cstdint>
+
+// Number of v/vt/vn elements covered by one index chunk
+#define OBJL_INDEX_CHUNK 4096
+
+// Structure: OBJIndexBlock
+// Description: An o, g or usemtl line and the attribute counts before it
+struct OBJIndexBlock
+{
+    // 'o', 'g' or 'u' (usemtl)
+    char Type;
+    // Object, group or material name
+    std::string Name;
+    // Byte offset of the line
+    uint64_t Offset;
+    // Number of v, vt and vn elements defined before the line
+    unsigned int PositionBase;
+    unsigned int TCoordBase;
+    unsigned int NormalBase;
+};
+
+// Structure: OBJIndexChunk
+// Description: Byte range holding OBJL_INDEX_CHUNK consecutive v, vt or vn elements
+struct OBJIndexChunk
+{
+    // Byte offset of the first element line
+    uint64_t Begin;
+    // Byte offset just past the last element line
+    uint64_t End;
+};
+
+// Structure: OBJIndex
+// Description: Byte offsets of the objects, groups and attributes of an .obj file
+struct OBJIndex
+{
+    // Size and modification time of the indexed file
+    uint64_t FileSize = 0;
+    int64_t FileTime = 0;
+
+    // mtllib Files
+    std::vector<std::string> MaterialLibraries;
+    // o/g/usemtl Boundaries
+    std::vector<OBJIndexBlock> Blocks;
+
+    // Attribute Chunks
+    std::vector<OBJIndexChunk> PositionChunks;
+    std::vector<OBJIndexChunk> TCoordChunks;
+    std::vector<OBJIndexChunk> NormalChunks;
+
+    // Attribute Counts
+    unsigned int PositionCount = 0;
+    unsigned int TCoordCount = 0;
+    unsigned int NormalCount = 0;
+};
+
+// Get the size and modification time of a file
+bool FileStamp(const std::string& Path, uint64_t& oSize, int64_t& oTime);
+
+// Get the path the index of an .obj file is stored at
+std::string OBJIndexPath(const std::string& Path);
+
+// Scan an .obj file and record its boundaries and attribute ranges
+bool BuildOBJIndex(const std::string& Path, OBJIndex& oIndex);
+
+// Write an index to disk
+bool SaveOBJIndex(const std::string& indexPath, const OBJIndex& index);
+
+// Read an index from disk
+//
+// Returns false if the index is missing, unreadable or
+// does not match the current size and time of the .obj file
+bool LoadOBJIndex(const std::string& indexPath, const std::string& Path, OBJIndex& oIndex);
+
+// Get the index of an .obj file
+//
+// The stored index is used when it is up to date, otherwise
+// the file is scanned and the new index is stored next to it
+bool GetOBJIndex(const std::string& Path, OBJIndex& oIndex);
+
+#endif
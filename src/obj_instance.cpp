@@ -0,0 +1,284 @@
+// obj_instance.cpp - Collapsing repeated newMeshes into instances of shared geometry
+
+#include <obj_instance.h>
+#include <obj_parallel.h>
+#include <obj_remap.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+// Size steps per doubling of the size, copies are looked for in
+//	their own step and the two next to it
+static const float kSizeSteps = 256.0f;
+
+// What a newMesh is compared by
+struct MeshShape
+{
+    glm::vec3 Center;
+    float Radius = 0.0f;
+    // Rotation frame, columns of a right handed orthonormal basis,
+    //	valid when Framed
+    glm::mat3 Frame = glm::mat3(1.0f);
+    bool Framed = false;
+    // Vertices the frame is built from, copies build theirs from
+    //	the same ones
+    unsigned int FrameVertices[2] = { 0, 0 };
+    // Hash of what moving and rotating keep, but the size
+    uint64_t Hash = 0;
+    // Size step, log2 of the radius in kSizeSteps
+    int64_t SizeStep = 0;
+};
+
+// Build the frame of a newMesh from the vertices i1, i2 around its center
+static bool BuildFrame(glm::mat3& oFrame, const std::vector<Vertex>& verts, const glm::vec3& center,
+    unsigned int i1, unsigned int i2)
+{
+    glm::vec3 a = verts[i1].Position - center, b = verts[i2].Position - center;
+    glm::vec3 c = CrossV3(a, b);
+    float la = MagnitudeV3(a), lc = MagnitudeV3(c);
+    if (!(la > 0.0f) || !(lc > 0.0f))
+        return false;
+
+    glm::vec3 x = a * (1.0f / la);
+    glm::vec3 z = c * (1.0f / lc);
+    oFrame = glm::mat3(x, CrossV3(z, x), z);
+    return true;
+}
+
+// Rotation taking frame from onto frame to, to * transpose(from)
+static glm::mat3 FrameRotation(const glm::mat3& from, const glm::mat3& to)
+{
+    glm::mat3 r;
+    for (int j = 0; j < 3; j++)
+    {
+        glm::vec3 row(from[0][j], from[1][j], from[2][j]);
+        r[j] = to[0] * row.x + to[1] * row.y + to[2] * row.z;
+    }
+    return r;
+}
+
+// Hash and measure a newMesh
+static void BuildShape(MeshShape& oShape, const newMesh& mesh, const std::string& materialName, const InstanceOptions& options)
+{
+    const std::vector<Vertex>& verts = mesh.Vertices;
+
+    glm::vec3 sum(0.0f);
+    for (const Vertex& v : verts)
+        sum = sum + v.Position;
+    oShape.Center = verts.empty() || !options.MatchTranslated ? glm::vec3(0.0f) : sum * (1.0f / float(verts.size()));
+
+    // Farthest vertex from the center sets the size and the first
+    //	frame axis, the one farthest from that axis the second
+    unsigned int i1 = 0;
+    float far2 = 0.0f;
+    for (size_t i = 0; i < verts.size(); i++)
+    {
+        glm::vec3 d = verts[i].Position - oShape.Center;
+        if (DotV3(d, d) > far2)
+        {
+            far2 = DotV3(d, d);
+            i1 = (unsigned int)i;
+        }
+    }
+    oShape.Radius = std::sqrt(far2);
+
+    if (options.MatchTranslated && options.MatchRotated && !verts.empty())
+    {
+        glm::vec3 a = verts[i1].Position - oShape.Center;
+        unsigned int i2 = i1;
+        float best = 0.0f;
+        for (size_t i = 0; i < verts.size(); i++)
+        {
+            glm::vec3 c = CrossV3(a, verts[i].Position - oShape.Center);
+            if (DotV3(c, c) > best)
+            {
+                best = DotV3(c, c);
+                i2 = (unsigned int)i;
+            }
+        }
+        oShape.Framed = BuildFrame(oShape.Frame, verts, oShape.Center, i1, i2);
+        oShape.FrameVertices[0] = i1;
+        oShape.FrameVertices[1] = i2;
+    }
+
+    // Moving and rotating keep the index lists, texture coordinates,
+    //	colors, material and size (kept apart as a step), without
+    //	MatchTranslated hash the positions
+    uint64_t h = HashWords(mesh.Indices.data(), mesh.Indices.size() * sizeof(unsigned int));
+    h = h * 0x9e3779b97f4a7c15ull ^ HashWords(mesh.FaceCorners.data(), mesh.FaceCorners.size() * sizeof(unsigned int));
+    h = h * 0x9e3779b97f4a7c15ull ^ HashWords(mesh.LineIndices.data(), mesh.LineIndices.size() * sizeof(unsigned int));
+    h = h * 0x9e3779b97f4a7c15ull ^ HashWords(mesh.PointIndices.data(), mesh.PointIndices.size() * sizeof(unsigned int));
+    h = h * 0x9e3779b97f4a7c15ull ^ HashWords(mesh.Colors.data(), mesh.Colors.size() * sizeof(glm::vec3));
+    h = h * 0x9e3779b97f4a7c15ull ^ verts.size();
+    for (const Vertex& v : verts)
+        h = h * 0x9e3779b97f4a7c15ull ^ HashWords(&v.TextureCoordinate, sizeof(v.TextureCoordinate));
+    h = h * 0x9e3779b97f4a7c15ull ^ std::hash<std::string>()(materialName);
+
+    if (options.MatchTranslated)
+    {
+        oShape.SizeStep = oShape.Radius > 0.0f ? (int64_t)std::floor(std::log2(oShape.Radius) * kSizeSteps) : INT64_MIN;
+    }
+    else
+    {
+        for (const Vertex& v : verts)
+            h = h * 0x9e3779b97f4a7c15ull ^ HashWords(&v.Position, sizeof(v.Position));
+    }
+    oShape.Hash = h;
+}
+
+// Check if a newMesh is a copy of a geometry, and where
+static bool MatchShape(glm::mat4& oTransform, const newMesh& geometry, const MeshShape& geometryShape,
+    const newMesh& mesh, const MeshShape& shape, const InstanceOptions& options)
+{
+    if (geometry.Vertices.size() != mesh.Vertices.size() || geometry.Indices != mesh.Indices
+        || geometry.FaceOffsets != mesh.FaceOffsets || geometry.FaceCorners != mesh.FaceCorners
+        || geometry.LineIndices != mesh.LineIndices || geometry.PointIndices != mesh.PointIndices)
+        return false;
+
+    // Colors are not moved by a transform, they must be equal
+    if (geometry.Colors.size() != mesh.Colors.size()
+        || (!mesh.Colors.empty() && memcmp(geometry.Colors.data(), mesh.Colors.data(), mesh.Colors.size() * sizeof(glm::vec3)) != 0))
+        return false;
+
+    // The frame of the copy comes from the vertices that made the
+    //	frame of the geometry, picking its own would break ties
+    //	(symmetric parts) differently after rounding
+    glm::mat3 rotation(1.0f);
+    if (geometryShape.Framed)
+    {
+        glm::mat3 frame;
+        if (!BuildFrame(frame, mesh.Vertices, shape.Center, geometryShape.FrameVertices[0], geometryShape.FrameVertices[1]))
+            return false;
+        rotation = FrameRotation(geometryShape.Frame, frame);
+    }
+
+    float tolerance = options.Tolerance * std::max(geometryShape.Radius, 1e-30f);
+    float normalTolerance = options.Tolerance * 10.0f;
+
+    for (size_t i = 0; i < mesh.Vertices.size(); i++)
+    {
+        const Vertex& g = geometry.Vertices[i];
+        const Vertex& v = mesh.Vertices[i];
+
+        glm::vec3 d = rotation * (g.Position - geometryShape.Center) + shape.Center - v.Position;
+        if (!(DotV3(d, d) <= tolerance * tolerance))
+            return false;
+
+        glm::vec3 n = rotation * g.Normal - v.Normal;
+        if (!(DotV3(n, n) <= normalTolerance * normalTolerance))
+            return false;
+
+        if (memcmp(&g.TextureCoordinate, &v.TextureCoordinate, sizeof(g.TextureCoordinate)) != 0)
+            return false;
+    }
+
+    // Geometries are kept around their center
+    oTransform = glm::mat4(1.0f);
+    for (int c = 0; c < 3; c++)
+        oTransform[c] = glm::vec4(rotation[c], 0.0f);
+    oTransform[3] = glm::vec4(shape.Center, 1.0f);
+    return true;
+}
+
+// Collapse identical loaded newMeshes into shared geometries
+void FindInstances(InstancedModel& oModel, const Loader& loader, const InstanceOptions& options)
+{
+    const std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    oModel = InstancedModel();
+
+    auto materialName = [&](size_t i) -> const std::string&
+    {
+        return i < loader.LoadedMaterialNames.size() ? loader.LoadedMaterialNames[i] : meshes[i].GetMaterial().name;
+    };
+
+    std::vector<MeshShape> shapes(meshes.size());
+    ParallelFor(meshes.size(), [&](size_t i)
+    {
+        BuildShape(shapes[i], meshes[i], materialName(i), options);
+    }, options.MaxThreads);
+
+    // newMeshes with one hash, in order
+    std::unordered_map<uint64_t, unsigned int> bucketIds;
+    std::vector<std::vector<unsigned int>> buckets;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        auto found = bucketIds.emplace(shapes[i].Hash, (unsigned int)buckets.size());
+        if (found.second)
+            buckets.emplace_back();
+        buckets[found.first->second].push_back((unsigned int)i);
+    }
+
+    // Compare within every bucket, the first newMesh of a geometry
+    //	becomes its original. A copy may round into the size step
+    //	next to its original's, so those are searched too.
+    std::vector<unsigned int> original(meshes.size());
+    std::vector<glm::mat4> transforms(meshes.size());
+    ParallelFor(buckets.size(), [&](size_t b)
+    {
+        std::unordered_map<int64_t, std::vector<unsigned int>> originals;
+        for (unsigned int i : buckets[b])
+        {
+            int64_t step = shapes[i].SizeStep;
+            bool matched = false;
+            for (int64_t near = -1; near <= 1 && !matched; near++)
+            {
+                // No steps next to a newMesh without size
+                if (near != 0 && step == INT64_MIN)
+                    continue;
+
+                auto found = originals.find(step + near);
+                if (found == originals.end())
+                    continue;
+
+                for (unsigned int o : found->second)
+                {
+                    if (MatchShape(transforms[i], meshes[o], shapes[o], meshes[i], shapes[i], options))
+                    {
+                        original[i] = o;
+                        matched = true;
+                        break;
+                    }
+                }
+            }
+            if (!matched)
+            {
+                originals[step].push_back(i);
+                original[i] = i;
+            }
+        }
+    }, options.MaxThreads);
+
+    // Geometries in order of their originals
+    std::vector<unsigned int> geometryIndex(meshes.size());
+    oModel.Instances.resize(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (original[i] == i)
+        {
+            geometryIndex[i] = (unsigned int)oModel.Geometries.size();
+
+            const MeshShape& shape = shapes[i];
+            newMesh geometry = meshes[i];
+            geometry.newMeshBounds.Reset();
+            for (Vertex& v : geometry.Vertices)
+            {
+                v.Position = v.Position - shape.Center;
+                geometry.newMeshBounds.Add(v.Position);
+            }
+            geometry.newMeshBounds.Finish(geometry.Vertices);
+            oModel.Geometries.push_back(std::move(geometry));
+
+            // The original is the geometry moved back to its center
+            transforms[i] = glm::mat4(1.0f);
+            transforms[i][3] = glm::vec4(shape.Center, 1.0f);
+        }
+
+        MeshInstance& instance = oModel.Instances[i];
+        instance.GeometryIndex = geometryIndex[original[i]];
+        instance.Transform = transforms[i];
+        instance.newMeshName = meshes[i].newMeshName;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef OBJ_INSTANCE_H
+#define OBJ_INSTANCE_H
+
+#include <obj_loader.h>
+
+// Structure: MeshInstance
+// Description: One placement of a shared geometry
+struct MeshInstance
+{
+    // Index into InstancedModel::Geometries
+    unsigned int GeometryIndex = 0;
+    // Transform from the geometry to the loaded newMesh
+    //	(column major, rotation and translation only)
+    glm::mat4 Transform = glm::mat4(1.0f);
+    // Name of the loaded newMesh
+    std::string newMeshName;
+};
+
+// Structure: InstancedModel
+// Description: Loaded newMeshes as shared geometries and their instances
+struct InstancedModel
+{
+    // One newMesh per distinct geometry, positions relative to the
+    //	center of its first copy when MatchTranslated
+    std::vector<newMesh> Geometries;
+    // Every loaded newMesh, in order
+    std::vector<MeshInstance> Instances;
+};
+
+// Structure: InstanceOptions
+// Description: Settings for detecting repeated geometry
+struct InstanceOptions
+{
+    InstanceOptions()
+    {
+        MatchTranslated = true;
+        MatchRotated = false;
+        Tolerance = 1e-4f;
+        MaxThreads = 0;
+    }
+
+    // Match copies moved to another place
+    bool MatchTranslated;
+    // Match copies that are also rotated, needs MatchTranslated
+    bool MatchRotated;
+    // Largest distance between a copy and its geometry, relative
+    //	to the radius of the geometry (normals within 10x this)
+    float Tolerance;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Collapse identical loaded newMeshes into shared geometries
+//
+// newMeshes are hashed by their index lists (faces, lines and points),
+// texture coordinates, colors, material and size around their center, which neither moving nor
+// rotating changes. newMeshes with equal hashes are then compared
+// vertex by vertex, so copies must keep the vertex order of the
+// original (as repeated groups of CAD exports do). Hashing and
+// comparing run in parallel.
+void FindInstances(InstancedModel& oModel, const Loader& loader, const InstanceOptions& options = InstanceOptions());
+
+#endif
@@ -0,0 +1,593 @@
+#ifndef OBJ_LAYOUT_H
+#define OBJ_LAYOUT_H
+
+#include <obj_loader.h>
+#include <obj_mtlcache.h>
+#include <obj_stream.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+// Pack a float in [-1, 1] into a signed normalized 8 bit integer
+inline int8_t PackSnorm8(float v)
+{
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int8_t)std::lround(v * 127.0f);
+}
+
+// Pack a float in [-1, 1] into a signed normalized 16 bit integer
+inline int16_t PackSnorm16(float v)
+{
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)std::lround(v * 32767.0f);
+}
+
+// Pack a float in [0, 1] into an unsigned normalized 16 bit integer
+inline uint16_t PackUnorm16(float v)
+{
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint16_t)std::lround(v * 65535.0f);
+}
+
+// Pack a float into a half float, rounding to nearest even
+inline uint16_t PackHalf(float v)
+{
+    uint32_t x;
+    memcpy(&x, &v, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t a = x & 0x7fffffff;
+
+    // Infinity and NaN
+    if (a >= 0x7f800000)
+        return (uint16_t)(sign | (a > 0x7f800000 ? 0x7e00 : 0x7c00));
+    // Too large, rounds to infinity
+    if (a >= 0x477ff000)
+        return (uint16_t)(sign | 0x7c00);
+    // Subnormal half or zero
+    if (a < 0x38800000)
+    {
+        float f;
+        memcpy(&f, &a, 4);
+        return (uint16_t)(sign | (uint32_t)std::nearbyint(f * 16777216.0f));
+    }
+
+    uint32_t h = (a - 0x38000000) >> 13;
+    uint32_t rest = a & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        h++;
+    return (uint16_t)(sign | h);
+}
+
+// Structure: FieldTraits
+// Description: Vertex traits that store attributes straight into fields of a vertex type
+//
+// Leave a field out (nullptr) and its attribute is not parsed:
+//	FieldTraits<MyVertex, &MyVertex::pos, nullptr, &MyVertex::uv>
+template <class V,
+    glm::vec3 V::*PositionField,
+    glm::vec3 V::*NormalField = nullptr,
+    glm::vec2 V::*TexCoordField = nullptr>
+struct FieldTraits
+{
+    typedef V VertexType;
+
+    static constexpr bool HasNormal = NormalField != nullptr;
+    static constexpr bool HasTexCoord = TexCoordField != nullptr;
+
+    static void SetPosition(V& v, const glm::vec3& p) { v.*PositionField = p; }
+    static void SetNormal(V& v, const glm::vec3& n) { v.*NormalField = n; }
+    static void SetTexCoord(V& v, const glm::vec2& t) { v.*TexCoordField = t; }
+};
+
+// Traits that fill the loader's own Vertex
+typedef FieldTraits<Vertex, &Vertex::Position, &Vertex::Normal, &Vertex::TextureCoordinate> DefaultVertexTraits;
+
+// Optional traits members, false when the traits do not declare them
+template <class Traits, class = void>
+struct LayoutHasNormal : std::false_type {};
+template <class Traits>
+struct LayoutHasNormal<Traits, std::enable_if_t<Traits::HasNormal>> : std::true_type {};
+
+template <class Traits, class = void>
+struct LayoutHasTexCoord : std::false_type {};
+template <class Traits>
+struct LayoutHasTexCoord<Traits, std::enable_if_t<Traits::HasTexCoord>> : std::true_type {};
+
+template <class Traits, class = void>
+struct LayoutHasMaterialIndex : std::false_type {};
+template <class Traits>
+struct LayoutHasMaterialIndex<Traits, std::enable_if_t<Traits::HasMaterialIndex>> : std::true_type {};
+
+template <class Traits, class = void>
+struct LayoutHasDoublePosition : std::false_type {};
+template <class Traits>
+struct LayoutHasDoublePosition<Traits, std::enable_if_t<Traits::HasDoublePosition>> : std::true_type {};
+
+template <class Traits, class = void>
+struct LayoutHasColor : std::false_type {};
+template <class Traits>
+struct LayoutHasColor<Traits, std::enable_if_t<Traits::HasColor>> : std::true_type {};
+
+// Structure: VectorStorage
+// Description: Keeps the v/vt/vn tables of a LayoutLoader in memory
+//
+// A storage gives the table type and makes empty tables, tables
+// need push_back, size and operator[] (see MappedArray)
+struct VectorStorage
+{
+    template <class T>
+    using Table = std::vector<T>;
+
+    template <class T>
+    Table<T> MakeTable() const { return Table<T>(); }
+};
+
+// Structure: LayoutMesh
+// Description: A newMesh with a user vertex type, same fields as newMesh
+template <class V>
+struct LayoutMesh
+{
+    // newMesh Name
+    std::string newMeshName;
+    // Vertex List
+    std::vector<V> Vertices;
+    // Index List
+    std::vector<unsigned int> Indices;
+    // Material
+    Material newMeshMaterial;
+    // Bounding Box and Sphere
+    Bounds newMeshBounds;
+};
+
+// Class: LayoutLoader
+// Description: OBJ loader that writes vertices straight into a user vertex type
+//
+// Traits describe the vertex type:
+//
+//	typedef ... VertexType;
+//	static void SetPosition(VertexType&, const glm::vec3&);
+//
+// and optionally, each attribute only parsed when declared true:
+//
+//	static constexpr bool HasNormal = true;
+//	static void SetNormal(VertexType&, const glm::vec3&);
+//	static constexpr bool HasTexCoord = true;
+//	static void SetTexCoord(VertexType&, const glm::vec2&);
+//	static constexpr bool HasMaterialIndex = true;
+//	static void SetMaterialIndex(VertexType&, unsigned int);
+//	static constexpr bool HasDoublePosition = true;
+//	static void SetPosition(VertexType&, const glm::dvec3&);
+//	static constexpr bool HasColor = true;
+//	static void SetColor(VertexType&, const glm::vec3&);
+//
+// The setters may pack into any format (see PackSnorm16, PackHalf).
+// Attributes that are not requested are skipped while parsing
+// and their code is compiled out. newMeshes are split at o, g and
+// usemtl lines like Loader does, one vertex per face corner.
+//
+// Storage decides where the v/vt/vn tables live while parsing.
+template <class Traits, class Storage = VectorStorage>
+class LayoutLoader
+{
+public:
+    typedef typename Traits::VertexType VertexType;
+    typedef LayoutMesh<VertexType> MeshType;
+
+    static constexpr bool HasNormal = LayoutHasNormal<Traits>::value;
+    static constexpr bool HasTexCoord = LayoutHasTexCoord<Traits>::value;
+    static constexpr bool HasMaterialIndex = LayoutHasMaterialIndex<Traits>::value;
+    static constexpr bool HasDoublePosition = LayoutHasDoublePosition<Traits>::value;
+    static constexpr bool HasColor = LayoutHasColor<Traits>::value;
+
+    // Positions are parsed and handed to SetPosition as double
+    //	with HasDoublePosition, otherwise as float
+    typedef std::conditional_t<HasDoublePosition, glm::dvec3, glm::vec3> PositionType;
+
+    LayoutLoader()
+    {
+        RebasePositions = false;
+        LoadedOrigin = glm::dvec3(0.0);
+        MaxMeshVertices = 0;
+    }
+
+    // Load a file into the loader
+    //
+    // Returns false if the file can not be read or is malformed
+    bool LoadFile(const std::string& Path);
+
+    // Loaded newMesh Objects
+    std::vector<MeshType> LoadednewMeshes;
+    // Loaded Material Objects
+    std::vector<Material> LoadedMaterials;
+    // Material Libraries the Loaded Materials came from
+    std::vector<std::shared_ptr<const MaterialLibrary>> LoadedLibraries;
+    // Bounding Box and Sphere of all Loaded newMeshes
+    Bounds LoadedBounds;
+
+    // Parse positions as double and store them relative to
+    //	LoadedOrigin, like Loader::RebasePositions
+    bool RebasePositions;
+    // Origin of the Loaded positions, the first position of the
+    //	file when RebasePositions is set, otherwise zero
+    glm::dvec3 LoadedOrigin;
+
+    // Where the v/vt/vn tables are kept, set up before loading
+    Storage TableStorage;
+
+    // Hand every finished newMesh to this instead of keeping it in
+    //	LoadednewMeshes, with the name of its material (which may
+    //	only be in a library named later). Returning false stops
+    //	the load.
+    std::function<bool(MeshType& mesh, const std::string& materialName)> OnnewMesh;
+
+    // Hand out newMeshes in parts of about this many vertices,
+    //	0 for no limit
+    size_t MaxMeshVertices;
+
+private:
+    // Skip spaces and tabs
+    static const char* SkipSpace(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        return p;
+    }
+
+    // Parse count floats or doubles, false if one is missing
+    template <class T>
+    static bool ParseFloats(const char*& p, const char* end, T* out, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            p = SkipSpace(p, end);
+            if (p < end && *p == '+')
+                p++;
+            auto r = std::from_chars(p, end, out[i]);
+            if (r.ec != std::errc())
+                return false;
+            p = r.ptr;
+        }
+        return true;
+    }
+
+    // Make the table of vertex colors (v x y z r g b), only
+    //	kept in the storage when the traits take colors
+    auto MakeColorTable() const
+    {
+        if constexpr (HasColor)
+            return TableStorage.template MakeTable<glm::vec3>();
+        else
+            return std::vector<glm::vec3>();
+    }
+
+    // Parse a face index and turn it into a position in a list
+    //
+    // Returns -1 for an empty index, -2 for a bad one
+    static long ParseIndex(const char*& p, const char* end, size_t listSize)
+    {
+        if (p >= end || *p == '/' || *p == ' ' || *p == '\t')
+            return -1;
+
+        long idx = 0;
+        auto r = std::from_chars(p, end, idx);
+        if (r.ec != std::errc())
+            return -2;
+        p = r.ptr;
+
+        idx = idx < 0 ? long(listSize) + idx : idx - 1;
+        return idx >= 0 && size_t(idx) < listSize ? idx : -2;
+    }
+};
+
+// Load a file into the loader
+template <class Traits, class Storage>
+bool LayoutLoader<Traits, Storage>::LoadFile(const std::string& Path)
+{
+    bool compressed = IsCompressedOBJ(Path);
+
+    // If the file is not an .obj file return false
+    if (!compressed && (Path.size() < 4 || Path.substr(Path.size() - 4, 4) != ".obj"))
+        return false;
+
+    std::ifstream file;
+    std::unique_ptr<PipelinedStreamBuf> inflated;
+    if (compressed)
+    {
+        inflated = OpenCompressedOBJ(Path);
+        if (!inflated)
+            return false;
+    }
+    else
+    {
+        file.open(Path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+    }
+    std::istream input(compressed ? (std::streambuf*)inflated.get() : file.rdbuf());
+
+    LoadednewMeshes.clear();
+    LoadedMaterials.clear();
+    LoadedLibraries.clear();
+    LoadedBounds.Reset();
+    LoadedOrigin = glm::dvec3(0.0);
+    bool haveOrigin = false;
+
+    auto Positions = TableStorage.template MakeTable<PositionType>();
+    auto TCoords = TableStorage.template MakeTable<glm::vec2>();
+    auto Normals = TableStorage.template MakeTable<glm::vec3>();
+    auto Colors = MakeColorTable();
+
+    // Material name of every newMesh, resolved once all libraries are read
+    std::vector<std::string> meshMaterials;
+    std::unordered_map<std::string, size_t> materialIndex;
+    std::string material;
+    unsigned int materialId = ~0u;
+
+    MeshType mesh;
+    std::string baseName;
+    unsigned int splits = 0;
+    size_t meshCount = 0;
+    bool failed = false;
+
+    // Finish the current newMesh if it has any faces
+    auto flush = [&]()
+    {
+        if (mesh.Indices.empty())
+            return false;
+        mesh.newMeshBounds.Finish();
+        meshCount++;
+
+        // Parts of the newMesh keep its name
+        std::string name = mesh.newMeshName;
+
+        if (OnnewMesh)
+        {
+            auto it = materialIndex.find(material);
+            if (it != materialIndex.end())
+                mesh.newMeshMaterial = LoadedMaterials[it->second];
+            failed |= !OnnewMesh(mesh, material);
+        }
+        else
+        {
+            LoadednewMeshes.push_back(std::move(mesh));
+            meshMaterials.push_back(material);
+        }
+
+        mesh = MeshType();
+        mesh.newMeshName = std::move(name);
+        return true;
+    };
+
+    struct Corner
+    {
+        long Position, TCoord, Normal;
+    };
+    std::vector<Corner> corners;
+    std::vector<Vertex> polygon;
+    std::vector<unsigned int> triangles;
+
+    std::string curline;
+    while (std::getline(input, curline))
+    {
+        const char* p = curline.data();
+        const char* end = p + curline.size();
+        if (end > p && end[-1] == '\r')
+            end--;
+
+        p = SkipSpace(p, end);
+        const char* tokenEnd = p;
+        while (tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\t')
+            tokenEnd++;
+        std::string_view token(p, tokenEnd - p);
+        p = tokenEnd;
+
+        if (token == "v")
+        {
+            if (HasDoublePosition || RebasePositions)
+            {
+                // Keep the double precision in the offset from the origin
+                glm::dvec3 v;
+                if (!ParseFloats(p, end, &v.x, 3))
+                    return false;
+                if (RebasePositions && !haveOrigin)
+                {
+                    LoadedOrigin = v;
+                    haveOrigin = true;
+                }
+                Positions.push_back(PositionType(v - LoadedOrigin));
+            }
+            else
+            {
+                glm::vec3 v;
+                if (!ParseFloats(p, end, &v.x, 3))
+                    return false;
+                Positions.push_back(PositionType(v));
+            }
+
+            if constexpr (HasColor)
+            {
+                // Positions without a color are white
+                glm::vec3 color;
+                if (!ParseFloats(p, end, &color.x, 3))
+                    color = glm::vec3(1.0f);
+                Colors.push_back(color);
+            }
+        }
+        else if (token == "vt")
+        {
+            if constexpr (HasTexCoord)
+            {
+                glm::vec2 t;
+                if (!ParseFloats(p, end, &t.x, 2))
+                    return false;
+                TCoords.push_back(t);
+            }
+        }
+        else if (token == "vn")
+        {
+            if constexpr (HasNormal)
+            {
+                glm::vec3 n;
+                if (!ParseFloats(p, end, &n.x, 3))
+                    return false;
+                Normals.push_back(n);
+            }
+        }
+        else if (token == "f")
+        {
+            corners.clear();
+            bool noNormal = false;
+
+            while ((p = SkipSpace(p, end)) < end)
+            {
+                Corner c = { ParseIndex(p, end, Positions.size()), -1, -1 };
+                if (c.Position < 0)
+                    return false;
+
+                if (p < end && *p == '/')
+                {
+                    p++;
+                    if constexpr (HasTexCoord)
+                        c.TCoord = ParseIndex(p, end, TCoords.size());
+                    else
+                        while (p < end && *p != '/' && *p != ' ' && *p != '\t')
+                            p++;
+                }
+                if (p < end && *p == '/')
+                {
+                    p++;
+                    if constexpr (HasNormal)
+                        c.Normal = ParseIndex(p, end, Normals.size());
+                }
+                while (p < end && *p != ' ' && *p != '\t')
+                    p++;
+
+                if (c.TCoord == -2 || c.Normal == -2)
+                    return false;
+                noNormal |= c.Normal < 0;
+                corners.push_back(c);
+            }
+
+            if (corners.size() < 3)
+                continue;
+
+            triangles.clear();
+            if (corners.size() == 3)
+            {
+                triangles = { 0, 1, 2 };
+            }
+            else
+            {
+                polygon.resize(corners.size());
+                for (size_t i = 0; i < corners.size(); i++)
+                    polygon[i].Position = glm::vec3(Positions[corners[i].Position]);
+                Loader::VertexTriangulation(triangles, polygon);
+            }
+
+            // Corners without a normal get the face normal, like Loader
+            glm::vec3 faceNormal(0.0f);
+            if constexpr (HasNormal)
+            {
+                if (noNormal)
+                {
+                    glm::vec3 p0(Positions[corners[0].Position]);
+                    glm::vec3 p1(Positions[corners[1].Position]);
+                    glm::vec3 p2(Positions[corners[2].Position]);
+                    faceNormal = CrossV3(p0 - p1, p2 - p1);
+                }
+            }
+
+            unsigned int base = (unsigned int)mesh.Vertices.size();
+            for (const Corner& c : corners)
+            {
+                VertexType v{};
+                const PositionType& position = Positions[c.Position];
+                Traits::SetPosition(v, position);
+                mesh.newMeshBounds.Add(glm::vec3(position));
+                LoadedBounds.Add(glm::vec3(position));
+
+                if constexpr (HasTexCoord)
+                    Traits::SetTexCoord(v, c.TCoord >= 0 ? TCoords[c.TCoord] : glm::vec2(0.0f));
+                if constexpr (HasNormal)
+                    Traits::SetNormal(v, noNormal ? faceNormal : Normals[c.Normal]);
+                if constexpr (HasMaterialIndex)
+                    Traits::SetMaterialIndex(v, materialId);
+                if constexpr (HasColor)
+                    Traits::SetColor(v, Colors[c.Position]);
+
+                mesh.Vertices.push_back(v);
+            }
+
+            for (unsigned int t : triangles)
+                mesh.Indices.push_back(base + t);
+
+            if (MaxMeshVertices && mesh.Vertices.size() >= MaxMeshVertices)
+                flush();
+            if (failed)
+                return false;
+        }
+        else if (token == "o" || token == "g")
+        {
+            flush();
+            baseName = tail(curline);
+            splits = 0;
+            mesh.newMeshName = baseName;
+        }
+        else if (token == "usemtl")
+        {
+            // Create new newMesh, if Material changes within a group
+            if (flush())
+                mesh.newMeshName = baseName + "_" + std::to_string(++splits + 1);
+
+            material = tail(curline);
+            auto it = materialIndex.find(material);
+            materialId = it == materialIndex.end() ? ~0u : (unsigned int)it->second;
+        }
+        else if (token == "mtllib")
+        {
+            // Material libraries are next to the .obj
+            size_t slash = Path.find_last_of('/');
+            std::string pathtomat = (slash == std::string::npos ? "" : Path.substr(0, slash + 1)) + tail(curline);
+
+            std::shared_ptr<const MaterialLibrary> library;
+            if (pathtomat.size() >= 4 && pathtomat.substr(pathtomat.size() - 4) == ".mtl")
+                library = GetMaterialLibrary(pathtomat);
+
+            if (library && std::find(LoadedLibraries.begin(), LoadedLibraries.end(), library) == LoadedLibraries.end())
+            {
+                LoadedLibraries.push_back(library);
+                for (const Material& m : library->Materials)
+                {
+                    materialIndex.emplace(m.name, LoadedMaterials.size());
+                    LoadedMaterials.push_back(m);
+                }
+            }
+        }
+    }
+
+    if (inflated && inflated->Failed())
+        return false;
+
+    flush();
+    if (failed)
+        return false;
+    LoadedBounds.Finish();
+
+    // Set Materials for each newMesh
+    for (size_t i = 0; i < LoadednewMeshes.size(); i++)
+    {
+        auto it = materialIndex.find(meshMaterials[i]);
+        if (it != materialIndex.end())
+            LoadednewMeshes[i].newMeshMaterial = LoadedMaterials[it->second];
+    }
+
+    return meshCount != 0;
+}
+
+#endif
@@ -1,6 +1,12 @@
 // OBJ_Loader.h - A Single Header OBJ Model Loader
 
 #include <obj_loader.h>
+#include <obj_async.h>
+#include <obj_mtlcache.h>
+#include <obj_stream.h>
+
+#include <algorithm>
+#include <unordered_map>
 
         // Default Constructor
 newMesh::newMesh()
@@ -14,6 +20,106 @@ newMesh::newMesh(std::vector<Vertex>& _Vertices, std::vector<unsigned int>& _Ind
     Indices = _Indices;
 }
 
+// Forget all positions
+void Bounds::Reset()
+{
+    Min = glm::vec3(0, 0, 0);
+    Max = glm::vec3(0, 0, 0);
+    Center = glm::vec3(0, 0, 0);
+    Radius = -1.0f;
+}
+
+// Grow the box and sphere to hold a position
+void Bounds::Add(const glm::vec3& p)
+{
+    if (Empty())
+    {
+        Min = Max = Center = p;
+        Radius = 0.0f;
+        return;
+    }
+
+    Min = glm::min(Min, p);
+    Max = glm::max(Max, p);
+
+    // Ritter: move the sphere towards the point just enough to hold it
+    glm::vec3 d = p - Center;
+    float dist2 = DotV3(d, d);
+    if (dist2 > Radius * Radius)
+    {
+        float dist = sqrtf(dist2);
+        float r = (Radius + dist) * 0.5f;
+        Center = Center + d * ((r - Radius) / dist);
+        Radius = r;
+    }
+}
+
+// Grow the box and sphere to hold other bounds
+void Bounds::Add(const Bounds& b)
+{
+    if (b.Empty())
+        return;
+    if (Empty())
+    {
+        *this = b;
+        return;
+    }
+
+    Min = glm::min(Min, b.Min);
+    Max = glm::max(Max, b.Max);
+
+    glm::vec3 d = b.Center - Center;
+    float dist = MagnitudeV3(d);
+    if (dist + b.Radius <= Radius)
+        return;
+    if (dist + Radius <= b.Radius)
+    {
+        Center = b.Center;
+        Radius = b.Radius;
+        return;
+    }
+
+    float r = (dist + Radius + b.Radius) * 0.5f;
+    Center = Center + d * ((r - Radius) / dist);
+    Radius = r;
+}
+
+// Swap in the sphere around the box if that one is smaller
+void Bounds::Finish()
+{
+    if (Empty())
+        return;
+
+    float boxRadius = MagnitudeV3(Max - Min) * 0.5f;
+    if (boxRadius < Radius)
+    {
+        Center = (Min + Max) * 0.5f;
+        Radius = boxRadius;
+    }
+}
+
+// Also try the sphere around the box center through the farthest vertex
+void Bounds::Finish(const std::vector<Vertex>& verts)
+{
+    Finish();
+    if (Empty())
+        return;
+
+    glm::vec3 boxCenter = (Min + Max) * 0.5f;
+    float farthest = 0.0f;
+    for (const Vertex& v : verts)
+    {
+        glm::vec3 d = v.Position - boxCenter;
+        farthest = std::max(farthest, DotV3(d, d));
+    }
+
+    if (sqrtf(farthest) < Radius)
+    {
+        Center = boxCenter;
+        Radius = sqrtf(farthest);
+    }
+}
+
 // glm::vec3 Cross Product
 glm::vec3 CrossV3(const glm::vec3 a, const glm::vec3 b)
 {
@@ -159,7 +265,7 @@ std::string tail(const std::string& in)
 }
 
 // Get first token of string
-inline std::string firstToken(const std::string& in)
+std::string firstToken(const std::string& in)
 {
     if (!in.empty())
     {
@@ -192,6 +298,11 @@ inline const T& getElement(const std::vector<T>& elements, std::string& index)
 // Default Constructor
 Loader::Loader()
 {
+    Task = nullptr;
+    RebasePositions = false;
+    KeepPolygons = false;
+    CopyMaterials = false;
+    LoadedOrigin = glm::dvec3(0.0);
 }
 Loader::~Loader()
 {
@@ -206,14 +317,38 @@ Loader::~Loader()
 // or unable to be loaded return false
 bool Loader::LoadFile(std::string Path)
 {
+    bool compressed = IsCompressedOBJ(Path);
+
     // If the file is not an .obj file return false
-    if (Path.substr(Path.size() - 4, 4) != ".obj")
+    if (!compressed && (Path.size() < 4 || Path.substr(Path.size() - 4, 4) != ".obj"))
         return false;
 
-    std::ifstream file(Path);
+    std::ifstream file;
+    std::unique_ptr<PipelinedStreamBuf> inflated;
 
-    if (!file.is_open())
-        return false;
+    // Compressed files are decompressed on their own thread
+    //	while the lines are parsed
+    if (compressed)
+    {
+        inflated = OpenCompressedOBJ(Path);
+
+        if (!inflated)
+            return false;
+    }
+    else
+    {
+        file.open(Path);
+
+        if (!file.is_open())
+            return false;
+
+        if (Task)
+        {
+            file.seekg(0, std::ios::end);
+            Task->SetBytesTotal((uint64_t)file.tellg());
+            file.seekg(0, std::ios::beg);
+        }
+    }
 
     LoadednewMeshes.clear();
     LoadedVertices.clear();
@@ -223,8 +358,36 @@ bool Loader::LoadFile(std::string Path)
     std::vector<glm::vec2> TCoords;
     std::vector<glm::vec3> Normals;
 
+    std::istream input(compressed ? (std::streambuf*)inflated.get() : file.rdbuf());
+    bool loaded = ParseOBJ(input, Path, Positions, TCoords, Normals);
+
+    if (inflated && inflated->Failed())
+        loaded = false;
+
+    file.close();
+
+    return loaded;
+}
+
+// Parse OBJ lines from a stream into the loaded lists
+//
+// Positions, TCoords and Normals may already hold the
+// attributes the lines refer to, v/vt/vn lines append to them.
+bool Loader::ParseOBJ(std::istream& file, const std::string& Path,
+    std::vector<glm::vec3>& Positions,
+    std::vector<glm::vec2>& TCoords,
+    std::vector<glm::vec3>& Normals)
+{
     std::vector<Vertex> Vertices;
     std::vector<unsigned int> Indices;
+    std::vector<unsigned int> FaceOffsets;
+    std::vector<unsigned int> FaceCorners;
+    std::vector<glm::vec3> VertexColors;
+    std::vector<unsigned int> LineIndices;
+    std::vector<unsigned int> PointIndices;
+
+    // Color of every position, empty until a v line has one
+    std::vector<glm::vec3> Colors;
 
     std::vector<std::string> newMeshMatNames;
 
@@ -233,6 +396,71 @@ bool Loader::LoadFile(std::string Path)
 
     newMesh tempnewMesh;
 
+    // Check if the newMesh being parsed has anything to draw
+    auto hasElements = [&]()
+    {
+        return (!Indices.empty() || !FaceCorners.empty() || !LineIndices.empty() || !PointIndices.empty())
+            && !Vertices.empty();
+    };
+
+    // Move the optional streams of the newMesh being parsed
+    auto takeElements = [&](newMesh& mesh)
+    {
+        mesh.FaceOffsets.swap(FaceOffsets);
+        mesh.FaceCorners.swap(FaceCorners);
+        mesh.Colors.swap(VertexColors);
+        mesh.LineIndices.swap(LineIndices);
+        mesh.PointIndices.swap(PointIndices);
+
+        // Vertices of the last faces may not have needed a color yet
+        if (!mesh.Colors.empty())
+            mesh.Colors.resize(Vertices.size(), glm::vec3(1.0f));
+    };
+
+    // Bounds of the newMesh being parsed
+    Bounds newMeshBounds;
+    LoadedBounds.Reset();
+
+    // Positions handed in (LoadGroups) are already rebased
+    bool haveOrigin = !Positions.empty();
+    if (!haveOrigin)
+        LoadedOrigin = glm::dvec3(0.0);
+
+    // Materials come from the libraries this file names
+    LoadedMaterials.clear();
+    LoadedLibraries.clear();
+
+    // First Loaded Material of every name, sharing its library
+    std::unordered_map<std::string, std::shared_ptr<const Material>> materialIndex;
+    auto findMaterial = [&](size_t i) -> std::shared_ptr<const Material>
+    {
+        if (i >= newMeshMatNames.size())
+            return nullptr;
+        auto it = materialIndex.find(newMeshMatNames[i]);
+        return it == materialIndex.end() ? nullptr : it->second;
+    };
+
+    // Point a newMesh at its material, copy it only when asked to
+    auto setMaterial = [&](newMesh& mesh, size_t i)
+    {
+        mesh.SharedMaterial = findMaterial(i);
+        if (CopyMaterials && mesh.SharedMaterial)
+            mesh.newMeshMaterial = *mesh.SharedMaterial;
+    };
+
+    // Hand a finished newMesh to an asynchronous caller right away
+    auto publishnewMesh = [&]()
+    {
+        if (!Task || !Task->StreamMeshes())
+            return;
+
+        newMesh mesh = LoadednewMeshes.back();
+        setMaterial(mesh, LoadednewMeshes.size() - 1);
+        Task->PushnewMesh(std::move(mesh));
+    };
+
+    uint64_t bytesParsed = 0;
+
 #ifdef OBJL_CONSOLE_OUTPUT
     const unsigned int outputEveryNth = 1000;
     unsigned int outputIndicator = outputEveryNth;
@@ -241,6 +469,17 @@ bool Loader::LoadFile(std::string Path)
     std::string curline;
     while (std::getline(file, curline))
     {
+        // Report progress and stop when cancelled
+        if (Task)
+        {
+            if (Task->Cancelled())
+                return false;
+
+            bytesParsed += curline.size() + 1;
+            if ((bytesParsed & 0xffff) < curline.size() + 1)
+                Task->SetBytesParsed(bytesParsed);
+        }
+
 #ifdef OBJL_CONSOLE_OUTPUT
         if ((outputIndicator = ((outputIndicator + 1) % outputEveryNth)) == 1)
         {
@@ -277,18 +516,23 @@ bool Loader::LoadFile(std::string Path)
             {
                 // Generate the newMesh to put into the array
 
-                if (!Indices.empty() && !Vertices.empty())
+                if (hasElements())
                 {
                     // Create newMesh
                     tempnewMesh = newMesh(Vertices, Indices);
                     tempnewMesh.newMeshName = newMeshname;
+                    tempnewMesh.newMeshBounds = newMeshBounds;
+                    tempnewMesh.newMeshBounds.Finish();
+                    takeElements(tempnewMesh);
 
                     // Insert newMesh
                     LoadednewMeshes.push_back(tempnewMesh);
+                    publishnewMesh();
 
                     // Cleanup
                     Vertices.clear();
                     Indices.clear();
+                    newMeshBounds.Reset();
                     newMeshname.clear();
 
                     newMeshname = tail(curline);
@@ -317,9 +561,35 @@ bool Loader::LoadFile(std::string Path)
             glm::vec3 vpos;
             split(tail(curline), spos, " ");
 
-            vpos.x = std::stof(spos[0]);
-            vpos.y = std::stof(spos[1]);
-            vpos.z = std::stof(spos[2]);
+            if (RebasePositions)
+            {
+                // Keep the double precision in the offset from the origin
+                glm::dvec3 dpos(std::stod(spos[0]), std::stod(spos[1]), std::stod(spos[2]));
+                if (!haveOrigin)
+                {
+                    LoadedOrigin = dpos;
+                    haveOrigin = true;
+                }
+                vpos = glm::vec3(dpos - LoadedOrigin);
+            }
+            else
+            {
+                vpos.x = std::stof(spos[0]);
+                vpos.y = std::stof(spos[1]);
+                vpos.z = std::stof(spos[2]);
+            }
+
+            // Vertex color (v x y z r g b), positions before the
+            //	first one are white
+            if (spos.size() >= 6)
+            {
+                Colors.resize(Positions.size(), glm::vec3(1.0f));
+                Colors.push_back(glm::vec3(std::stof(spos[3]), std::stof(spos[4]), std::stof(spos[5])));
+            }
+            else if (!Colors.empty())
+            {
+                Colors.push_back(glm::vec3(1.0f));
+            }
 
             Positions.push_back(vpos);
         }
@@ -353,28 +623,87 @@ bool Loader::LoadFile(std::string Path)
         {
             // Generate the vertices
             std::vector<Vertex> vVerts;
-            GenVerticesFromRawOBJ(vVerts, Positions, TCoords, Normals, curline);
+            if (Colors.empty())
+            {
+                GenVerticesFromRawOBJ(vVerts, Positions, TCoords, Normals, curline);
+            }
+            else
+            {
+                VertexColors.resize(Vertices.size(), glm::vec3(1.0f));
+                GenVerticesFromRawOBJ(vVerts, Positions, TCoords, Normals, curline, &Colors, &VertexColors);
+            }
 
             // Add Vertices
             for (int i = 0; i < int(vVerts.size()); i++)
             {
                 Vertices.push_back(vVerts[i]);
 
+                newMeshBounds.Add(vVerts[i].Position);
+                LoadedBounds.Add(vVerts[i].Position);
+
                 LoadedVertices.push_back(vVerts[i]);
             }
 
-            std::vector<unsigned int> iIndices;
+            // Keep the face as it is, triangulated on demand
+            if (KeepPolygons)
+            {
+                if (FaceCorners.empty())
+                    FaceOffsets.assign(1, 0);
+                for (int i = 0; i < int(vVerts.size()); i++)
+                    FaceCorners.push_back((unsigned int)(Vertices.size() - vVerts.size()) + i);
+                FaceOffsets.push_back((unsigned int)FaceCorners.size());
+            }
+            else
+            {
+                std::vector<unsigned int> iIndices;
+
+                VertexTriangulation(iIndices, vVerts);
+
+                // Add Indices
+                for (int i = 0; i < int(iIndices.size()); i++)
+                {
+                    unsigned int indnum = (unsigned int)((Vertices.size()) - vVerts.size()) + iIndices[i];
+                    Indices.push_back(indnum);
 
-            VertexTriangulation(iIndices, vVerts);
+                    indnum = (unsigned int)((LoadedVertices.size()) - vVerts.size()) + iIndices[i];
+                    LoadedIndices.push_back(indnum);
+                }
+            }
+        }
+        // Generate Polylines (l) and Points (p), checking the
+        //	first character keeps this off the path of other lines
+        if ((curline[0] == 'l' || curline[0] == 'p') && (firstToken(curline) == "l" || firstToken(curline) == "p"))
+        {
+            std::vector<Vertex> vVerts;
+            if (!Colors.empty())
+                VertexColors.resize(Vertices.size(), glm::vec3(1.0f));
+            GenElementVerticesFromRawOBJ(vVerts, Positions, TCoords, curline,
+                Colors.empty() ? nullptr : &Colors, &VertexColors);
 
-            // Add Indices
-            for (int i = 0; i < int(iIndices.size()); i++)
+            unsigned int base = (unsigned int)Vertices.size();
+            for (int i = 0; i < int(vVerts.size()); i++)
             {
-                unsigned int indnum = (unsigned int)((Vertices.size()) - vVerts.size()) + iIndices[i];
-                Indices.push_back(indnum);
+                Vertices.push_back(vVerts[i]);
 
-                indnum = (unsigned int)((LoadedVertices.size()) - vVerts.size()) + iIndices[i];
-                LoadedIndices.push_back(indnum);
+                newMeshBounds.Add(vVerts[i].Position);
+                LoadedBounds.Add(vVerts[i].Position);
+
+                LoadedVertices.push_back(vVerts[i]);
+            }
+
+            if (curline[0] == 'l')
+            {
+                // A polyline is kept as its segments
+                for (unsigned int i = 1; i < (unsigned int)vVerts.size(); i++)
+                {
+                    LineIndices.push_back(base + i - 1);
+                    LineIndices.push_back(base + i);
+                }
+            }
+            else
+            {
+                for (unsigned int i = 0; i < (unsigned int)vVerts.size(); i++)
+                    PointIndices.push_back(base + i);
             }
         }
         // Get newMesh Material Name
@@ -383,11 +712,14 @@ bool Loader::LoadFile(std::string Path)
             newMeshMatNames.push_back(tail(curline));
 
             // Create new newMesh, if Material changes within a group
-            if (!Indices.empty() && !Vertices.empty())
+            if (hasElements())
             {
                 // Create newMesh
                 tempnewMesh = newMesh(Vertices, Indices);
                 tempnewMesh.newMeshName = newMeshname;
+                tempnewMesh.newMeshBounds = newMeshBounds;
+                tempnewMesh.newMeshBounds.Finish();
+                takeElements(tempnewMesh);
                 int i = 2;
                 while (1) {
                     tempnewMesh.newMeshName = newMeshname + "_" + std::to_string(i);
@@ -400,10 +732,12 @@ bool Loader::LoadFile(std::string Path)
 
                 // Insert newMesh
                 LoadednewMeshes.push_back(tempnewMesh);
+                publishnewMesh();
 
                 // Cleanup
                 Vertices.clear();
                 Indices.clear();
+                newMeshBounds.Reset();
             }
 
 #ifdef OBJL_CONSOLE_OUTPUT
@@ -436,7 +770,20 @@ bool Loader::LoadFile(std::string Path)
 #endif
 
             // Load Materials
+            if (Task)
+                Task->SetPhase(LoadPhase::Materials);
+
+            size_t loaded = LoadedLibraries.size();
             LoadMaterials(pathtomat);
+            for (size_t j = loaded; j < LoadedLibraries.size(); j++)
+            {
+                const std::shared_ptr<const MaterialLibrary>& library = LoadedLibraries[j];
+                for (const Material& m : library->Materials)
+                    materialIndex.emplace(m.name, std::shared_ptr<const Material>(library, &m));
+            }
+
+            if (Task)
+                Task->SetPhase(LoadPhase::Parsing);
         }
     }
 
@@ -444,35 +791,48 @@ bool Loader::LoadFile(std::string Path)
     std::cout << std::endl;
 #endif
 
+    if (Task)
+    {
+        Task->SetBytesParsed(bytesParsed);
+        Task->SetPhase(LoadPhase::Finishing);
+    }
+
     // Deal with last newMesh
 
-    if (!Indices.empty() && !Vertices.empty())
+    if (hasElements())
     {
         // Create newMesh
         tempnewMesh = newMesh(Vertices, Indices);
         tempnewMesh.newMeshName = newMeshname;
+        tempnewMesh.newMeshBounds = newMeshBounds;
+        tempnewMesh.newMeshBounds.Finish();
+        takeElements(tempnewMesh);
 
         // Insert newMesh
         LoadednewMeshes.push_back(tempnewMesh);
+        publishnewMesh();
     }
 
-    file.close();
+    // The spheres of the newMeshes together may be tighter
+    Bounds merged;
+    for (const newMesh& m : LoadednewMeshes)
+        merged.Add(m.newMeshBounds);
+    LoadedBounds.Finish();
+    if (!merged.Empty() && merged.Radius < LoadedBounds.Radius)
+    {
+        LoadedBounds.Center = merged.Center;
+        LoadedBounds.Radius = merged.Radius;
+    }
 
     // Set Materials for each newMesh
-    for (int i = 0; i < newMeshMatNames.size(); i++)
+    LoadedMaterialNames.assign(LoadednewMeshes.size(), std::string());
+    for (size_t i = 0; i < newMeshMatNames.size() && i < LoadednewMeshes.size(); i++)
     {
-        std::string matname = newMeshMatNames[i];
+        LoadedMaterialNames[i] = newMeshMatNames[i];
 
         // Find corresponding material name in loaded materials
-        // when found copy material variables into newMesh material
-        for (int j = 0; j < LoadedMaterials.size(); j++)
-        {
-            if (LoadedMaterials[j].name == matname)
-            {
-                LoadednewMeshes[i].newMeshMaterial = LoadedMaterials[j];
-                break;
-            }
-        }
+        // when found point the newMesh at it
+        setMaterial(LoadednewMeshes[i], i);
     }
 
     if (LoadednewMeshes.empty() && LoadedVertices.empty() && LoadedIndices.empty())
@@ -489,7 +849,9 @@ void Loader::GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
     const std::vector<glm::vec3>& iPositions,
     const std::vector<glm::vec2>& iTCoords,
     const std::vector<glm::vec3>& iNormals,
-    std::string icurline)
+    std::string icurline,
+    const std::vector<glm::vec3>* iColors,
+    std::vector<glm::vec3>* oColors)
 {
     std::vector<std::string> sface, svert;
     Vertex vVert;
@@ -535,6 +897,10 @@ void Loader::GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
             }
         }
 
+        // Color of the position, for every vertex stored below
+        if (iColors && svert.size() >= 1 && svert.size() <= 3)
+            oColors->push_back(getElement(*iColors, svert[0]));
+
         // Calculate and store the vertex
         switch (vtype)
         {
@@ -594,6 +960,37 @@ void Loader::GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
     }
 }
 
+// Generate vertices from a list of positions,
+//	tcoords and a line (l) or point (p) element
+void Loader::GenElementVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
+    const std::vector<glm::vec3>& iPositions,
+    const std::vector<glm::vec2>& iTCoords,
+    std::string icurline,
+    const std::vector<glm::vec3>* iColors,
+    std::vector<glm::vec3>* oColors)
+{
+    std::vector<std::string> selem, svert;
+    split(tail(icurline), selem, " ");
+
+    for (int i = 0; i < int(selem.size()); i++)
+    {
+        // v1 or v1/vt1
+        split(selem[i], svert, "/");
+        if (svert.empty() || svert[0].empty())
+            continue;
+
+        Vertex vVert;
+        vVert.Position = getElement(iPositions, svert[0]);
+        vVert.Normal = glm::vec3(0, 0, 0);
+        vVert.TextureCoordinate = svert.size() >= 2 && !svert[1].empty()
+            ? getElement(iTCoords, svert[1]) : glm::vec2(0, 0);
+        oVerts.push_back(vVert);
+
+        if (iColors)
+            oColors->push_back(getElement(*iColors, svert[0]));
+    }
+}
+
 // Triangulate a list of vertices into a face by printing
 //	inducies corresponding with triangles within it
 void Loader::VertexTriangulation(std::vector<unsigned int>& oIndices, const std::vector<Vertex>& iVerts)
@@ -762,164 +1159,55 @@ void Loader::VertexTriangulation(std::vector<unsigned int>& oIndices, const std:
     }
 }
 
+// Whether LoadedVertices and LoadedIndices hold the Loaded newMeshes
+bool Loader::GatheredLoadednewMeshes() const
+{
+    size_t vertexCount = 0, indexCount = 0;
+    for (const newMesh& mesh : LoadednewMeshes)
+    {
+        vertexCount += mesh.Vertices.size();
+        indexCount += mesh.Indices.size();
+    }
+    return vertexCount == LoadedVertices.size() && indexCount == LoadedIndices.size();
+}
+
+// Rebuild LoadedVertices and LoadedIndices from the Loaded newMeshes
+void Loader::GatherLoadednewMeshes()
+{
+    LoadedVertices.clear();
+    LoadedIndices.clear();
+    for (const newMesh& mesh : LoadednewMeshes)
+    {
+        unsigned int base = (unsigned int)LoadedVertices.size();
+        LoadedVertices.insert(LoadedVertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+        for (unsigned int index : mesh.Indices)
+            LoadedIndices.push_back(base + index);
+    }
+}
+
 // Load Materials from .mtl file
 bool Loader::LoadMaterials(std::string path)
 {
     // If the file is not a material file return false
-    if (path.substr(path.size() - 4, path.size()) != ".mtl")
+    if (path.size() < 4 || path.substr(path.size() - 4, path.size()) != ".mtl")
         return false;
 
-    std::ifstream file(path);
+    std::shared_ptr<const MaterialLibrary> library = GetMaterialLibrary(path);
 
     // If the file is not found return false
-    if (!file.is_open())
+    if (!library)
         return false;
 
-    Material tempMaterial;
-
-    bool listening = false;
-
-    // Go through each line looking for material variables
-    std::string curline;
-    while (std::getline(file, curline))
+    // A library named twice is only used once
+    for (const auto& used : LoadedLibraries)
     {
-        // new material and material name
-        if (firstToken(curline) == "newmtl")
-        {
-            if (!listening)
-            {
-                listening = true;
-
-                if (curline.size() > 7)
-                {
-                    tempMaterial.name = tail(curline);
-                }
-                else
-                {
-                    tempMaterial.name = "none";
-                }
-            }
-            else
-            {
-                // Generate the material
-
-                // Push Back loaded Material
-                LoadedMaterials.push_back(tempMaterial);
-
-                // Clear Loaded Material
-                tempMaterial = Material();
-
-                if (curline.size() > 7)
-                {
-                    tempMaterial.name = tail(curline);
-                }
-                else
-                {
-                    tempMaterial.name = "none";
-                }
-            }
-        }
-        // Ambient Color
-        if (firstToken(curline) == "Ka")
-        {
-            std::vector<std::string> temp;
-            split(tail(curline), temp, " ");
-
-            if (temp.size() != 3)
-                continue;
-
-            tempMaterial.Ka.x = std::stof(temp[0]);
-            tempMaterial.Ka.y = std::stof(temp[1]);
-            tempMaterial.Ka.z = std::stof(temp[2]);
-        }
-        // Diffuse Color
-        if (firstToken(curline) == "Kd")
-        {
-            std::vector<std::string> temp;
-            split(tail(curline), temp, " ");
-
-            if (temp.size() != 3)
-                continue;
-
-            tempMaterial.Kd.x = std::stof(temp[0]);
-            tempMaterial.Kd.y = std::stof(temp[1]);
-            tempMaterial.Kd.z = std::stof(temp[2]);
-        }
-        // Specular Color
-        if (firstToken(curline) == "Ks")
-        {
-            std::vector<std::string> temp;
-            split(tail(curline), temp, " ");
-
-            if (temp.size() != 3)
-                continue;
-
-            tempMaterial.Ks.x = std::stof(temp[0]);
-            tempMaterial.Ks.y = std::stof(temp[1]);
-            tempMaterial.Ks.z = std::stof(temp[2]);
-        }
-        // Specular Exponent
-        if (firstToken(curline) == "Ns")
-        {
-            tempMaterial.Ns = std::stof(tail(curline));
-        }
-        // Optical Density
-        if (firstToken(curline) == "Ni")
-        {
-            tempMaterial.Ni = std::stof(tail(curline));
-        }
-        // Dissolve
-        if (firstToken(curline) == "d")
-        {
-            tempMaterial.d = std::stof(tail(curline));
-        }
-        // Illumination
-        if (firstToken(curline) == "illum")
-        {
-            tempMaterial.illum = std::stoi(tail(curline));
-        }
-        // Ambient Texture Map
-        if (firstToken(curline) == "map_Ka")
-        {
-            tempMaterial.map_Ka = tail(curline);
-        }
-        // Diffuse Texture Map
-        if (firstToken(curline) == "map_Kd")
-        {
-            tempMaterial.map_Kd = tail(curline);
-        }
-        // Specular Texture Map
-        if (firstToken(curline) == "map_Ks")
-        {
-            tempMaterial.map_Ks = tail(curline);
-        }
-        // Specular Hightlight Map
-        if (firstToken(curline) == "map_Ns")
-        {
-            tempMaterial.map_Ns = tail(curline);
-        }
-        // Alpha Texture Map
-        if (firstToken(curline) == "map_d")
-        {
-            tempMaterial.map_d = tail(curline);
-        }
-        // Bump Map
-        if (firstToken(curline) == "map_Bump" || firstToken(curline) == "map_bump" || firstToken(curline) == "bump")
-        {
-            tempMaterial.map_bump = tail(curline);
-        }
+        if (used == library)
+            return true;
     }
 
-    // Deal with last material
+    LoadedLibraries.push_back(library);
+    if (CopyMaterials)
+        LoadedMaterials.insert(LoadedMaterials.end(), library->Materials.begin(), library->Materials.end());
 
-    // Push Back loaded Material
-    LoadedMaterials.push_back(tempMaterial);
-
-    // Test to see if anything was loaded
-    // If not return false
-    if (LoadedMaterials.empty())
-        return false;
-    // If so return true
-    else
-        return true;
-}
\ No newline at end of file
+    return true;
+}
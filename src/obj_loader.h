@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <memory>
 #include <math.h>
 #include<glm/glm.hpp>
 
@@ -66,6 +67,43 @@ struct Material
     std::string map_bump;
 };
 
+// Structure: Bounds
+// Description: Axis aligned box and bounding sphere of a set of positions
+//
+// Both grow one position at a time, so they can be tracked while
+// a file is parsed instead of in a pass over the vertices after.
+struct Bounds
+{
+    Bounds()
+    {
+        Reset();
+    }
+
+    // Box Minimum
+    glm::vec3 Min;
+    // Box Maximum
+    glm::vec3 Max;
+    // Sphere Center
+    glm::vec3 Center;
+    // Sphere Radius, negative while empty
+    float Radius;
+
+    // Forget all positions
+    void Reset();
+    // Grow the box and sphere to hold a position
+    void Add(const glm::vec3& p);
+    // Grow the box and sphere to hold other bounds
+    void Add(const Bounds& b);
+    // Swap in the sphere around the box if that one is smaller
+    void Finish();
+    // Also try the sphere around the box center through the farthest
+    //	vertex, a tighter sphere for one more pass over the vertices;
+    //	the loaders leave it to passes that go over them anyway
+    void Finish(const std::vector<Vertex>& verts);
+    // Check if no position was added
+    bool Empty() const { return Radius < 0; }
+};
+
 // Structure: newMesh
 // Description: A Simple newMesh Object that holds	a name, a vertex list, and an index list
 class newMesh
@@ -82,8 +120,37 @@ public:
     // Index List
     std::vector<unsigned int> Indices;
 
-    // Material
+    // Level of Detail Index Lists (coarser with each level),
+    //	indexing into the same Vertex List
+    std::vector<std::vector<unsigned int>> LODIndices;
+    // Error of each LOD relative to the newMesh extent
+    std::vector<float> LODErrors;
+
+    // Faces as loaded (KeepPolygons), face f has the corners
+    //	FaceCorners[FaceOffsets[f]] up to FaceCorners[FaceOffsets[f + 1]]
+    std::vector<unsigned int> FaceOffsets;
+    // Vertex of every face corner
+    std::vector<unsigned int> FaceCorners;
+
+    // Color of every vertex (v x y z r g b), empty when
+    //	no position of the file has one
+    std::vector<glm::vec3> Colors;
+    // Line segments (l), two vertices each
+    std::vector<unsigned int> LineIndices;
+    // Points (p), one vertex each
+    std::vector<unsigned int> PointIndices;
+
+    // Material, shared with the library it comes from, nullptr
+    //	when no loaded library has the usemtl name
+    std::shared_ptr<const Material> SharedMaterial;
+    // Copy of the Material, filled with Loader::CopyMaterials
     Material newMeshMaterial;
+
+    // The Material, SharedMaterial when set, otherwise newMeshMaterial
+    const Material& GetMaterial() const { return SharedMaterial ? *SharedMaterial : newMeshMaterial; }
+
+    // Bounding Box and Sphere
+    Bounds newMeshBounds;
 };
 
 // Namespace: Math
@@ -132,6 +199,9 @@ std::string firstToken(const std::string& in);
 template <class T>
 inline const T& getElement(const std::vector<T>& elements, std::string& index);
 
+class LoadTask;
+struct MaterialLibrary;
+
 // Class: Loader
 // Description: The OBJ Model Loader
 class Loader
@@ -147,29 +217,107 @@ public:
     //
     // If the file is unable to be found
     // or unable to be loaded return false
+    //
+    // .obj.gz and .obj.zst files are read when built
+    // with OBJL_USE_ZLIB / OBJL_USE_ZSTD
     bool LoadFile(std::string Path);
 
+    // Load only the named objects/groups of a file
+    //
+    // Uses the offset index stored next to the file (building it
+    // when missing or stale) to parse just the selected o/g blocks
+    // and the v/vt/vn chunks their faces reference
+    bool LoadGroups(std::string Path, const std::vector<std::string>& Names);
+
+    // Load a file into the loader on a background thread
+    //
+    // The returned task reports progress, can be cancelled and,
+    // with streamMeshes, hands out each newMesh once it is done.
+    // Do not use the loader until the task is Ready.
+    std::shared_ptr<LoadTask> LoadFileAsync(std::string Path, bool streamMeshes = false);
+
     // Loaded newMesh Objects
     std::vector<newMesh> LoadednewMeshes;
     // Loaded Vertex Objects
     std::vector<Vertex> LoadedVertices;
     // Loaded Index Positions
     std::vector<unsigned int> LoadedIndices;
-    // Loaded Material Objects
+    // Loaded Material Objects, copied from LoadedLibraries with
+    //	CopyMaterials, otherwise empty
     std::vector<Material> LoadedMaterials;
+    // Material name (usemtl) of every Loaded newMesh, kept also
+    //	when no Loaded Material has it, so materials can be rebound
+    std::vector<std::string> LoadedMaterialNames;
+    // Material Libraries the Loaded Materials come from, shared
+    //	through the material cache with every other loader using them,
+    //	newMesh::SharedMaterial points into them
+    std::vector<std::shared_ptr<const MaterialLibrary>> LoadedLibraries;
+    // Bounding Box and Sphere of all Loaded newMeshes
+    Bounds LoadedBounds;
+
+    // Parse positions as double and store them relative to
+    //	LoadedOrigin, for models with large coordinates
+    //	(georeferenced survey or BIM data) that lose precision
+    //	as floats. Set before loading, off by default.
+    bool RebasePositions;
+    // Origin of the Loaded positions, the first position of the
+    //	file when RebasePositions is set, otherwise zero
+    glm::dvec3 LoadedOrigin;
+
+    // Keep faces as polygons in FaceOffsets/FaceCorners instead of
+    //	triangulating them, Indices and LoadedIndices stay empty until
+    //	TriangulateFaces (obj_polygon.h). Set before loading, off by default.
+    bool KeepPolygons;
+
+    // Also copy the materials into LoadedMaterials and every
+    //	newMesh::newMeshMaterial, as loads did before the material
+    //	cache. Set before loading, off by default.
+    bool CopyMaterials;
+
+    // Triangulate a list of vertices into a face by printing
+    //	induces corresponding with triangles within it
+    //
+    // Only the positions are used, front ends with their own
+    //	vertex types (obj_layout.h) triangulate through it too
+    static void VertexTriangulation(std::vector<unsigned int>& oIndices, const std::vector<Vertex>& iVerts);
+
+    // Whether LoadedVertices and LoadedIndices hold the Loaded
+    //	newMeshes in turn, which they do unless the newMeshes were
+    //	streamed out of a LoadTask
+    bool GatheredLoadednewMeshes() const;
+
+    // Rebuild LoadedVertices and LoadedIndices from the Loaded
+    //	newMeshes, for passes that change them after loading
+    void GatherLoadednewMeshes();
 
 private:
+    // Asynchronous load this loader is running, if any
+    LoadTask* Task;
+
+    // Parse OBJ lines from a stream into the loaded lists
+    bool ParseOBJ(std::istream& file, const std::string& Path,
+        std::vector<glm::vec3>& Positions,
+        std::vector<glm::vec2>& TCoords,
+        std::vector<glm::vec3>& Normals);
+
     // Generate vertices from a list of positions,
     //	tcoords, normals and a face line
     void GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
         const std::vector<glm::vec3>& iPositions,
         const std::vector<glm::vec2>& iTCoords,
         const std::vector<glm::vec3>& iNormals,
-        std::string icurline);
+        std::string icurline,
+        const std::vector<glm::vec3>* iColors = nullptr,
+        std::vector<glm::vec3>* oColors = nullptr);
 
-    // Triangulate a list of vertices into a face by printing
-    //	induces corresponding with triangles within it
-    void VertexTriangulation(std::vector<unsigned int>& oIndices, const std::vector<Vertex>& iVerts);
+    // Generate vertices from a list of positions,
+    //	tcoords and a line (l) or point (p) element
+    void GenElementVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
+        const std::vector<glm::vec3>& iPositions,
+        const std::vector<glm::vec2>& iTCoords,
+        std::string icurline,
+        const std::vector<glm::vec3>* iColors = nullptr,
+        std::vector<glm::vec3>* oColors = nullptr);
 
     // Load Materials from .mtl file
     bool LoadMaterials(std::string path);
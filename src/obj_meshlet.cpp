@@ -0,0 +1,274 @@
+// obj_meshlet.cpp - Meshlet partitioning with bounding spheres and normal cones
+
+#include <obj_meshlet.h>
+#include <obj_parallel.h>
+#include <obj_polygon.h>
+#include <obj_remap.h>
+
+#include <algorithm>
+
+// Marks a vertex that is not in the current meshlet
+static const unsigned char kNotInMeshlet = 0xff;
+
+// Compute the bounding sphere and normal cone of a finished meshlet
+static void MeshletBounds(Meshlet& m, const MeshletData& data, const std::vector<Vertex>& iVerts)
+{
+    const unsigned int* mverts = &data.MeshletVertices[m.VertexOffset];
+    const unsigned char* mtris = &data.MeshletTriangles[m.TriangleOffset * 3];
+
+    // Ritter's bounding sphere, seeded with the two most distant points
+    glm::vec3 a = iVerts[mverts[0]].Position;
+    glm::vec3 b = a;
+    float best = -1.0f;
+    for (unsigned int i = 0; i < m.VertexCount; i++)
+    {
+        glm::vec3 d = iVerts[mverts[i]].Position - a;
+        if (DotV3(d, d) > best)
+        {
+            best = DotV3(d, d);
+            b = iVerts[mverts[i]].Position;
+        }
+    }
+    best = -1.0f;
+    for (unsigned int i = 0; i < m.VertexCount; i++)
+    {
+        glm::vec3 d = iVerts[mverts[i]].Position - b;
+        if (DotV3(d, d) > best)
+        {
+            best = DotV3(d, d);
+            a = iVerts[mverts[i]].Position;
+        }
+    }
+
+    glm::vec3 center = (a + b) * 0.5f;
+    float radius = MagnitudeV3(a - b) * 0.5f;
+    for (unsigned int i = 0; i < m.VertexCount; i++)
+    {
+        glm::vec3 p = iVerts[mverts[i]].Position;
+        float d = MagnitudeV3(p - center);
+        if (d > radius)
+        {
+            float r = (radius + d) * 0.5f;
+            center = center + (p - center) * ((r - radius) / d);
+            radius = r;
+        }
+    }
+
+    m.Center = center;
+    m.Radius = radius;
+
+    // Normal cone from the average triangle normal
+    glm::vec3 axis(0, 0, 0);
+    for (unsigned int t = 0; t < m.TriangleCount; t++)
+    {
+        glm::vec3 n = GenTriNormal(iVerts[mverts[mtris[t * 3]]].Position,
+            iVerts[mverts[mtris[t * 3 + 1]]].Position,
+            iVerts[mverts[mtris[t * 3 + 2]]].Position);
+        float len = MagnitudeV3(n);
+        if (len > 0)
+            axis = axis + n / len;
+    }
+
+    m.ConeApex = center;
+    m.ConeAxis = glm::vec3(0, 0, 0);
+    m.ConeCutoff = 1.0f;
+
+    float axisLen = MagnitudeV3(axis);
+    if (axisLen <= 0)
+        return;
+    axis = axis / axisLen;
+
+    float minDot = 1.0f;
+    float maxT = 0.0f;
+    for (unsigned int t = 0; t < m.TriangleCount; t++)
+    {
+        glm::vec3 p0 = iVerts[mverts[mtris[t * 3]]].Position;
+        glm::vec3 n = GenTriNormal(p0,
+            iVerts[mverts[mtris[t * 3 + 1]]].Position,
+            iVerts[mverts[mtris[t * 3 + 2]]].Position);
+        float len = MagnitudeV3(n);
+        if (len <= 0)
+            continue;
+        n = n / len;
+
+        float dn = DotV3(axis, n);
+        minDot = std::min(minDot, dn);
+
+        // Move the apex back until every triangle plane is in front of it
+        if (dn > 0)
+            maxT = std::max(maxT, DotV3(center - p0, n) / dn);
+    }
+
+    // Cones wider than ~84 degrees never cull anything
+    if (minDot <= 0.1f)
+        return;
+
+    m.ConeAxis = axis;
+    m.ConeApex = center - axis * maxT;
+    m.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+// Split an index list into meshlets
+void BuildMeshlets(MeshletData& oMeshlets,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    const MeshletOptions& options)
+{
+    oMeshlets.Meshlets.clear();
+    oMeshlets.MeshletVertices.clear();
+    oMeshlets.MeshletTriangles.clear();
+
+    unsigned int maxVerts = std::min(std::max(options.MaxVertices, 3u), 255u);
+    unsigned int maxTris = std::max(options.MaxTriangles, 1u);
+
+    size_t triCount = iIndices.size() / 3;
+    size_t vertCount = iVerts.size();
+    if (triCount == 0)
+        return;
+
+    // Loader gives every face its own vertices, so corners share a
+    //	meshlet vertex when their vertices are equal (the first of
+    //	them stands for all) and triangles are neighbours when their
+    //	corners share a position
+    std::vector<unsigned int> vertexRemap, vertexFirst, positionRemap, positionFirst;
+    BuildRemap(vertexRemap, vertexFirst, iVerts, [](const Vertex& v) -> const Vertex& { return v; });
+    BuildRemap(positionRemap, positionFirst, iVerts, [](const Vertex& v) -> const glm::vec3& { return v.Position; });
+    size_t positionCount = positionFirst.size();
+
+    std::vector<unsigned int> corners(triCount * 3);
+    for (size_t i = 0; i < triCount * 3; i++)
+        corners[i] = vertexFirst[vertexRemap[iIndices[i]]];
+
+    // Live triangles around every position
+    std::vector<unsigned int> adjOffset(positionCount + 1, 0), adjCount(positionCount, 0);
+    for (size_t i = 0; i < triCount * 3; i++)
+        adjOffset[positionRemap[corners[i]] + 1]++;
+    for (size_t p = 0; p < positionCount; p++)
+        adjOffset[p + 1] += adjOffset[p];
+
+    std::vector<unsigned int> adjTris(triCount * 3);
+    for (size_t i = 0; i < triCount * 3; i++)
+    {
+        unsigned int p = positionRemap[corners[i]];
+        adjTris[adjOffset[p] + adjCount[p]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<char> live(triCount, 1);
+    std::vector<unsigned char> local(vertCount, kNotInMeshlet);
+
+    // Number of vertices a triangle would add to the current meshlet
+    auto newVertices = [&](size_t t)
+    {
+        unsigned int a = corners[t * 3], b = corners[t * 3 + 1], c = corners[t * 3 + 2];
+        return (local[a] == kNotInMeshlet)
+            + (local[b] == kNotInMeshlet && b != a)
+            + (local[c] == kNotInMeshlet && c != a && c != b);
+    };
+
+    Meshlet cur = {};
+    size_t seed = 0;
+
+    for (size_t emitted = 0; emitted < triCount; emitted++)
+    {
+        // Prefer the neighbour that shares the most vertices
+        size_t best = triCount;
+        unsigned int bestExtra = 4;
+        for (unsigned int i = 0; i < cur.VertexCount && bestExtra > 0; i++)
+        {
+            unsigned int p = positionRemap[oMeshlets.MeshletVertices[cur.VertexOffset + i]];
+            for (unsigned int k = 0; k < adjCount[p]; k++)
+            {
+                unsigned int t = adjTris[adjOffset[p] + k];
+                unsigned int extra = newVertices(t);
+                if (extra < bestExtra)
+                {
+                    best = t;
+                    bestExtra = extra;
+                }
+            }
+        }
+
+        // Nothing connected left, start from the next unused triangle
+        if (best == triCount)
+        {
+            while (!live[seed])
+                seed++;
+            best = seed;
+            bestExtra = newVertices(best);
+        }
+
+        // Full, close the meshlet and start a new one at this triangle
+        if (cur.VertexCount + bestExtra > maxVerts || cur.TriangleCount + 1 > maxTris)
+        {
+            MeshletBounds(cur, oMeshlets, iVerts);
+            oMeshlets.Meshlets.push_back(cur);
+
+            for (unsigned int i = 0; i < cur.VertexCount; i++)
+                local[oMeshlets.MeshletVertices[cur.VertexOffset + i]] = kNotInMeshlet;
+
+            cur = Meshlet();
+            cur.VertexOffset = (unsigned int)oMeshlets.MeshletVertices.size();
+            cur.TriangleOffset = (unsigned int)(oMeshlets.MeshletTriangles.size() / 3);
+        }
+
+        // Add the triangle
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = corners[best * 3 + k];
+            if (local[v] == kNotInMeshlet)
+            {
+                local[v] = (unsigned char)cur.VertexCount++;
+                oMeshlets.MeshletVertices.push_back(v);
+            }
+            oMeshlets.MeshletTriangles.push_back(local[v]);
+        }
+        cur.TriangleCount++;
+
+        // Take it out of the adjacency of its positions
+        live[best] = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int p = positionRemap[corners[best * 3 + k]];
+            unsigned int* list = &adjTris[adjOffset[p]];
+            for (unsigned int j = 0; j < adjCount[p]; j++)
+            {
+                if (list[j] == best)
+                {
+                    list[j] = list[--adjCount[p]];
+                    break;
+                }
+            }
+        }
+    }
+
+    if (cur.TriangleCount > 0)
+    {
+        MeshletBounds(cur, oMeshlets, iVerts);
+        oMeshlets.Meshlets.push_back(cur);
+    }
+}
+
+// Split a newMesh into meshlets
+void BuildMeshlets(MeshletData& oMeshlets, const newMesh& mesh, const MeshletOptions& options)
+{
+    // A newMesh kept as polygons is triangulated first
+    TriangulateOptions triangulate;
+    triangulate.MaxThreads = options.MaxThreads;
+    std::vector<unsigned int> triangulated;
+    BuildMeshlets(oMeshlets, mesh.Vertices, TriangleIndices(mesh, triangulated, triangulate), options);
+}
+
+// Split every loaded newMesh into meshlets, in parallel
+void BuildMeshlets(std::vector<MeshletData>& oMeshlets, const Loader& loader, const MeshletOptions& options)
+{
+    oMeshlets.clear();
+    oMeshlets.resize(loader.LoadednewMeshes.size());
+
+    MeshletOptions single = options;
+    single.MaxThreads = 1;
+
+    ParallelFor(loader.LoadednewMeshes.size(), [&](size_t i)
+    {
+        BuildMeshlets(oMeshlets[i], loader.LoadednewMeshes[i], single);
+    }, options.MaxThreads);
+}
@@ -0,0 +1,88 @@
+#ifndef OBJ_MESHLET_H
+#define OBJ_MESHLET_H
+
+#include <obj_loader.h>
+
+// Structure: Meshlet
+// Description: A small cluster of triangles with its culling data
+struct Meshlet
+{
+    // First entry in MeshletVertices
+    unsigned int VertexOffset;
+    // First triangle in MeshletTriangles (in triangles, not bytes)
+    unsigned int TriangleOffset;
+    // Number of vertices
+    unsigned int VertexCount;
+    // Number of triangles
+    unsigned int TriangleCount;
+
+    // Bounding Sphere Center
+    glm::vec3 Center;
+    // Bounding Sphere Radius
+    float Radius;
+
+    // Normal Cone Apex
+    glm::vec3 ConeApex;
+    // Normal Cone Axis
+    glm::vec3 ConeAxis;
+    // Normal Cone Cutoff, the meshlet is backfacing when
+    //	dot(normalize(ConeApex - camera), ConeAxis) >= ConeCutoff
+    //	a cutoff of 1 means the cone is too wide to ever cull
+    float ConeCutoff;
+};
+
+// Structure: MeshletData
+// Description: The packed meshlets of one newMesh
+struct MeshletData
+{
+    // Meshlets and their culling data
+    std::vector<Meshlet> Meshlets;
+    // Vertex List of every meshlet, indexing into newMesh::Vertices
+    std::vector<unsigned int> MeshletVertices;
+    // Triangles of every meshlet, 3 local vertex indices each
+    std::vector<unsigned char> MeshletTriangles;
+};
+
+// Structure: MeshletOptions
+// Description: Limits of the generated meshlets
+struct MeshletOptions
+{
+    MeshletOptions()
+    {
+        MaxVertices = 64;
+        MaxTriangles = 124;
+        MaxThreads = 0;
+    }
+
+    // Most vertices in a meshlet (at most 255)
+    unsigned int MaxVertices;
+    // Most triangles in a meshlet
+    unsigned int MaxTriangles;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Split an index list into meshlets
+//
+// Triangles are grown from a seed into neighbours that share the
+// most vertices with the current meshlet, so every meshlet stays
+// a compact patch with tight bounds and normal cone. Triangles are
+// neighbours when they share a position, and equal vertices are
+// stored once (as the first of them), since loaded newMeshes give
+// every face vertices of its own.
+void BuildMeshlets(MeshletData& oMeshlets,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    const MeshletOptions& options = MeshletOptions());
+
+// Split a newMesh into meshlets
+//
+// A newMesh kept as polygons (KeepPolygons) is triangulated first
+void BuildMeshlets(MeshletData& oMeshlets, const newMesh& mesh, const MeshletOptions& options = MeshletOptions());
+
+// Split every loaded newMesh into meshlets, in parallel
+//
+// oMeshlets gets one entry per loaded newMesh
+void BuildMeshlets(std::vector<MeshletData>& oMeshlets, const Loader& loader, const MeshletOptions& options = MeshletOptions());
+
+#endif
@@ -0,0 +1,49 @@
+// obj_model.cpp - Immutable models shared between threads
+
+#include <obj_model.h>
+
+Model::Model()
+    : origin(0.0)
+{
+}
+
+// One newMesh that keeps the whole model alive
+std::shared_ptr<const newMesh> Model::Mesh(size_t i) const
+{
+    return std::shared_ptr<const newMesh>(shared_from_this(), &meshes[i]);
+}
+
+// Move the results of a loader into a new Model
+std::shared_ptr<const Model> Model::Take(Loader& loader)
+{
+    std::shared_ptr<Model> model(new Model());
+    model->meshes = std::move(loader.LoadednewMeshes);
+    model->vertices = std::move(loader.LoadedVertices);
+    model->indices = std::move(loader.LoadedIndices);
+    model->materials = std::move(loader.LoadedMaterials);
+    model->materialNames = std::move(loader.LoadedMaterialNames);
+    model->libraries = std::move(loader.LoadedLibraries);
+    model->bounds = loader.LoadedBounds;
+    model->origin = loader.LoadedOrigin;
+
+    // Moved from vectors are left valid but unspecified
+    loader.LoadednewMeshes.clear();
+    loader.LoadedVertices.clear();
+    loader.LoadedIndices.clear();
+    loader.LoadedMaterials.clear();
+    loader.LoadedMaterialNames.clear();
+    loader.LoadedLibraries.clear();
+    loader.LoadedBounds.Reset();
+
+    return model;
+}
+
+// Load a file into a new Model
+std::shared_ptr<const Model> LoadModel(const std::string& Path, bool rebasePositions)
+{
+    Loader loader;
+    loader.RebasePositions = rebasePositions;
+    if (!loader.LoadFile(Path))
+        return nullptr;
+    return Model::Take(loader);
+}
@@ -0,0 +1,109 @@
+#ifndef OBJ_MODEL_H
+#define OBJ_MODEL_H
+
+#include <obj_loader.h>
+
+#include <atomic>
+
+// Structure: ArrayView
+// Description: A read only view of contiguous elements owned by something else
+template <class T>
+struct ArrayView
+{
+    ArrayView() : Data(nullptr), Count(0) {}
+    ArrayView(const T* data, size_t count) : Data(data), Count(count) {}
+    ArrayView(const std::vector<T>& v) : Data(v.data()), Count(v.size()) {}
+
+    const T* begin() const { return Data; }
+    const T* end() const { return Data + Count; }
+    const T& operator[](size_t i) const { return Data[i]; }
+    size_t size() const { return Count; }
+    bool empty() const { return Count == 0; }
+
+    // First element
+    const T* Data;
+    // Number of elements
+    size_t Count;
+};
+
+// Class: Model
+// Description: An immutable loaded model, shared between threads as std::shared_ptr<const Model>
+//
+// Nothing changes a Model once it is made, so any number of threads
+// may read it without locking. The views it hands out point into
+// its own storage and stay valid while a reference to it is held,
+// whatever loads happen meanwhile.
+class Model : public std::enable_shared_from_this<Model>
+{
+public:
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Loaded newMeshes
+    ArrayView<newMesh> Meshes() const { return meshes; }
+    // All vertices, the newMeshes in turn (Loader::LoadedVertices)
+    ArrayView<Vertex> Vertices() const { return vertices; }
+    // All indices into Vertices (Loader::LoadedIndices)
+    ArrayView<unsigned int> Indices() const { return indices; }
+    // Loaded Materials, only copied with Loader::CopyMaterials,
+    //	newMesh::SharedMaterial points into Libraries() either way
+    ArrayView<Material> Materials() const { return materials; }
+    // Material name (usemtl) of every newMesh
+    ArrayView<std::string> MaterialNames() const { return materialNames; }
+    // Libraries the materials came from
+    ArrayView<std::shared_ptr<const MaterialLibrary>> Libraries() const { return libraries; }
+
+    // Vertices and indices of one newMesh
+    ArrayView<Vertex> MeshVertices(size_t i) const { return meshes[i].Vertices; }
+    ArrayView<unsigned int> MeshIndices(size_t i) const { return meshes[i].Indices; }
+
+    // One newMesh that keeps the whole model alive
+    std::shared_ptr<const newMesh> Mesh(size_t i) const;
+
+    // Bounding Box and Sphere of all newMeshes
+    const Bounds& ModelBounds() const { return bounds; }
+    // Origin of the positions (Loader::RebasePositions)
+    const glm::dvec3& Origin() const { return origin; }
+
+    // Move the results of a loader into a new Model
+    //
+    // The loader is left empty and can load the next file at once
+    static std::shared_ptr<const Model> Take(Loader& loader);
+
+private:
+    Model();
+
+    std::vector<newMesh> meshes;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<Material> materials;
+    std::vector<std::string> materialNames;
+    std::vector<std::shared_ptr<const MaterialLibrary>> libraries;
+    Bounds bounds;
+    glm::dvec3 origin;
+};
+
+// Load a file into a new Model
+//
+// Returns nullptr if the file can not be loaded
+std::shared_ptr<const Model> LoadModel(const std::string& Path, bool rebasePositions = false);
+
+// Class: SharedModel
+// Description: The current Model of something, swapped by one thread while others read it
+//
+// Readers Get the current Model and keep it for as long as they
+// need, a Set meanwhile only affects later Gets.
+class SharedModel
+{
+public:
+    // Get the current Model, nullptr before the first Set
+    std::shared_ptr<const Model> Get() const { return std::atomic_load(&current); }
+
+    // Make a Model the current one
+    void Set(std::shared_ptr<const Model> model) { std::atomic_store(&current, std::move(model)); }
+
+private:
+    std::shared_ptr<const Model> current;
+};
+
+#endif
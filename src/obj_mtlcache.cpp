@@ -0,0 +1,297 @@
+// obj_mtlcache.cpp - Process wide cache of parsed material libraries
+
+#include <obj_mtlcache.h>
+#include <obj_index.h>
+
+#include <filesystem>
+#include <future>
+#include <mutex>
+
+// Parse materials from .mtl lines
+bool ParseMTL(std::istream& file, std::vector<Material>& oMaterials)
+{
+    size_t first = oMaterials.size();
+
+    Material tempMaterial;
+
+    bool listening = false;
+
+    // Go through each line looking for material variables
+    std::string curline;
+    while (std::getline(file, curline))
+    {
+        // new material and material name
+        if (firstToken(curline) == "newmtl")
+        {
+            if (!listening)
+            {
+                listening = true;
+
+                if (curline.size() > 7)
+                {
+                    tempMaterial.name = tail(curline);
+                }
+                else
+                {
+                    tempMaterial.name = "none";
+                }
+            }
+            else
+            {
+                // Generate the material
+
+                // Push Back loaded Material
+                oMaterials.push_back(tempMaterial);
+
+                // Clear Loaded Material
+                tempMaterial = Material();
+
+                if (curline.size() > 7)
+                {
+                    tempMaterial.name = tail(curline);
+                }
+                else
+                {
+                    tempMaterial.name = "none";
+                }
+            }
+        }
+        // Ambient Color
+        if (firstToken(curline) == "Ka")
+        {
+            std::vector<std::string> temp;
+            split(tail(curline), temp, " ");
+
+            if (temp.size() != 3)
+                continue;
+
+            tempMaterial.Ka.x = std::stof(temp[0]);
+            tempMaterial.Ka.y = std::stof(temp[1]);
+            tempMaterial.Ka.z = std::stof(temp[2]);
+        }
+        // Diffuse Color
+        if (firstToken(curline) == "Kd")
+        {
+            std::vector<std::string> temp;
+            split(tail(curline), temp, " ");
+
+            if (temp.size() != 3)
+                continue;
+
+            tempMaterial.Kd.x = std::stof(temp[0]);
+            tempMaterial.Kd.y = std::stof(temp[1]);
+            tempMaterial.Kd.z = std::stof(temp[2]);
+        }
+        // Specular Color
+        if (firstToken(curline) == "Ks")
+        {
+            std::vector<std::string> temp;
+            split(tail(curline), temp, " ");
+
+            if (temp.size() != 3)
+                continue;
+
+            tempMaterial.Ks.x = std::stof(temp[0]);
+            tempMaterial.Ks.y = std::stof(temp[1]);
+            tempMaterial.Ks.z = std::stof(temp[2]);
+        }
+        // Specular Exponent
+        if (firstToken(curline) == "Ns")
+        {
+            tempMaterial.Ns = std::stof(tail(curline));
+        }
+        // Optical Density
+        if (firstToken(curline) == "Ni")
+        {
+            tempMaterial.Ni = std::stof(tail(curline));
+        }
+        // Dissolve
+        if (firstToken(curline) == "d")
+        {
+            tempMaterial.d = std::stof(tail(curline));
+        }
+        // Illumination
+        if (firstToken(curline) == "illum")
+        {
+            tempMaterial.illum = std::stoi(tail(curline));
+        }
+        // Ambient Texture Map
+        if (firstToken(curline) == "map_Ka")
+        {
+            tempMaterial.map_Ka = tail(curline);
+        }
+        // Diffuse Texture Map
+        if (firstToken(curline) == "map_Kd")
+        {
+            tempMaterial.map_Kd = tail(curline);
+        }
+        // Specular Texture Map
+        if (firstToken(curline) == "map_Ks")
+        {
+            tempMaterial.map_Ks = tail(curline);
+        }
+        // Specular Hightlight Map
+        if (firstToken(curline) == "map_Ns")
+        {
+            tempMaterial.map_Ns = tail(curline);
+        }
+        // Alpha Texture Map
+        if (firstToken(curline) == "map_d")
+        {
+            tempMaterial.map_d = tail(curline);
+        }
+        // Bump Map
+        if (firstToken(curline) == "map_Bump" || firstToken(curline) == "map_bump" || firstToken(curline) == "bump")
+        {
+            tempMaterial.map_bump = tail(curline);
+        }
+    }
+
+    // Deal with last material
+
+    // Push Back loaded Material
+    oMaterials.push_back(tempMaterial);
+
+    // Test to see if anything was loaded
+    // If not return false
+    if (oMaterials.size() == first)
+        return false;
+    // If so return true
+    else
+        return true;
+}
+
+// Structure: MaterialCache
+// Description: Cached libraries and the file stamps they were parsed from
+struct MaterialCache
+{
+    struct Entry
+    {
+        uint64_t Size;
+        int64_t Time;
+        std::shared_future<std::shared_ptr<const MaterialLibrary>> Library;
+    };
+
+    std::mutex Mutex;
+    std::unordered_map<std::string, Entry> Entries;
+    MaterialCacheStats Stats;
+};
+
+// The cache, created on first use
+static MaterialCache& Cache()
+{
+    static MaterialCache cache;
+    return cache;
+}
+
+// Get the parsed materials of a .mtl file from the process wide cache
+std::shared_ptr<const MaterialLibrary> GetMaterialLibrary(const std::string& Path)
+{
+    std::error_code ec;
+    std::string key = std::filesystem::canonical(Path, ec).string();
+    if (ec)
+        return nullptr;
+
+    uint64_t size;
+    int64_t time;
+    if (!FileStamp(key, size, time))
+        return nullptr;
+
+    MaterialCache& cache = Cache();
+    std::promise<std::shared_ptr<const MaterialLibrary>> parsed;
+    std::shared_future<std::shared_ptr<const MaterialLibrary>> pending;
+    {
+        std::lock_guard<std::mutex> lock(cache.Mutex);
+
+        auto it = cache.Entries.find(key);
+        if (it != cache.Entries.end() && it->second.Size == size && it->second.Time == time)
+        {
+            cache.Stats.Hits++;
+            pending = it->second.Library;
+        }
+        else
+        {
+            if (it != cache.Entries.end())
+                cache.Stats.Reloads++;
+            else
+                cache.Stats.Misses++;
+
+            // Claim the library, other callers wait for this parse
+            cache.Entries[key] = { size, time, parsed.get_future().share() };
+        }
+    }
+
+    // Cached or being parsed by another thread
+    if (pending.valid())
+        return pending.get();
+
+    // Forget a failed parse so the next caller tries again
+    auto forget = [&]()
+    {
+        std::lock_guard<std::mutex> lock(cache.Mutex);
+        auto it = cache.Entries.find(key);
+        if (it != cache.Entries.end() && it->second.Size == size && it->second.Time == time)
+            cache.Entries.erase(it);
+    };
+
+    std::shared_ptr<MaterialLibrary> library = std::make_shared<MaterialLibrary>();
+    library->Path = key;
+
+    try
+    {
+        std::ifstream file(key);
+        if (!file.is_open() || !ParseMTL(file, library->Materials))
+            library = nullptr;
+    }
+    catch (...)
+    {
+        forget();
+        parsed.set_exception(std::current_exception());
+        throw;
+    }
+
+    if (library)
+    {
+        for (size_t i = 0; i < library->Materials.size(); i++)
+            library->Names.emplace(library->Materials[i].name, (unsigned int)i);
+    }
+    else
+    {
+        forget();
+    }
+
+    parsed.set_value(library);
+    return library;
+}
+
+// Drop every cached library
+void ClearMaterialCache()
+{
+    MaterialCache& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.Mutex);
+    cache.Entries.clear();
+}
+
+// Get the counters of the material library cache
+MaterialCacheStats GetMaterialCacheStats()
+{
+    MaterialCache& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.Mutex);
+    MaterialCacheStats stats = cache.Stats;
+    stats.Libraries = cache.Entries.size();
+    return stats;
+}
+
+// Copy the materials of libraries into one list, in turn
+std::vector<Material> CollectMaterials(const std::vector<std::shared_ptr<const MaterialLibrary>>& libraries)
+{
+    size_t count = 0;
+    for (const auto& library : libraries)
+        count += library->Materials.size();
+
+    std::vector<Material> materials;
+    materials.reserve(count);
+    for (const auto& library : libraries)
+        materials.insert(materials.end(), library->Materials.begin(), library->Materials.end());
+    return materials;
+}
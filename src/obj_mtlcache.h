@@ -0,0 +1,73 @@
+#ifndef OBJ_MTLCACHE_H
+#define OBJ_MTLCACHE_H
+
+#include <obj_loader.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+// Structure: MaterialLibrary
+// Description: The parsed materials of one .mtl file, shared by every loader using it
+struct MaterialLibrary
+{
+    // Canonical path of the file
+    std::string Path;
+    // Materials in file order
+    std::vector<Material> Materials;
+    // Index of the first material with each name
+    std::unordered_map<std::string, unsigned int> Names;
+
+    // Find a material by name, nullptr when there is none
+    const Material* Find(const std::string& name) const
+    {
+        auto it = Names.find(name);
+        return it == Names.end() ? nullptr : &Materials[it->second];
+    }
+};
+
+// Structure: MaterialCacheStats
+// Description: Counters of the material library cache
+struct MaterialCacheStats
+{
+    // Requests answered from the cache
+    uint64_t Hits = 0;
+    // Libraries parsed because they were not cached
+    uint64_t Misses = 0;
+    // Libraries parsed again because the file changed
+    uint64_t Reloads = 0;
+    // Libraries in the cache
+    size_t Libraries = 0;
+};
+
+// Parse materials from .mtl lines
+//
+// Materials are appended to oMaterials,
+// returns false when nothing was read
+bool ParseMTL(std::istream& file, std::vector<Material>& oMaterials);
+
+// Get the parsed materials of a .mtl file from the process wide cache
+//
+// Libraries are keyed by canonical path and parsed once, a file
+// whose size or modification time changed is parsed again. Safe to
+// call from concurrent loaders, a caller asking for a library that
+// another thread is parsing waits for it. Returns nullptr when the
+// file can not be read.
+//
+// Loaders hand the materials out by reference (newMesh::SharedMaterial
+// keeps its library alive), copies are only made with
+// Loader::CopyMaterials.
+std::shared_ptr<const MaterialLibrary> GetMaterialLibrary(const std::string& Path);
+
+// Drop every cached library, loaders keep the ones they use
+void ClearMaterialCache();
+
+// Get the counters of the material library cache
+MaterialCacheStats GetMaterialCacheStats();
+
+// Copy the materials of libraries into one list, in turn
+//
+// The list LoadedMaterials holds with Loader::CopyMaterials, for
+// writers that take a list of materials.
+std::vector<Material> CollectMaterials(const std::vector<std::shared_ptr<const MaterialLibrary>>& libraries);
+
+#endif
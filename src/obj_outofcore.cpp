@@ -0,0 +1,265 @@
+// obj_outofcore.cpp - Memory mapped attribute tables and an on-disk newMesh store
+
+#include <obj_outofcore.h>
+
+#include <cstdio>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OBJL_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Get the directory for temporary files
+static std::string TempDirectoryOr(const std::string& directory)
+{
+    if (!directory.empty())
+        return directory;
+    std::error_code ec;
+    std::string temp = std::filesystem::temp_directory_path(ec).string();
+    return ec ? std::string(".") : temp;
+}
+
+MappedFile::MappedFile()
+    : fd(-1), data(nullptr), size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef OBJL_HAVE_MMAP
+    if (data)
+        munmap(data, size);
+    if (fd >= 0)
+        close(fd);
+#else
+    free(data);
+#endif
+}
+
+// Create an empty file in a directory
+bool MappedFile::Create(const std::string& directory)
+{
+#ifdef OBJL_HAVE_MMAP
+    std::string name = TempDirectoryOr(directory) + "/objl-XXXXXX";
+    fd = mkstemp(&name[0]);
+    if (fd < 0)
+        return false;
+
+    // Nothing else needs the name, the file goes away once closed
+    unlink(name.c_str());
+#endif
+    return true;
+}
+
+// Grow the file and its mapping to at least bytes
+bool MappedFile::Resize(size_t bytes)
+{
+    if (bytes <= size)
+        return true;
+
+#ifdef OBJL_HAVE_MMAP
+    size_t page = PageSize();
+    bytes = (bytes + page - 1) / page * page;
+
+    if (ftruncate(fd, (off_t)bytes) != 0)
+        return false;
+
+    // Map the whole file again, its contents are kept by the file
+    if (data)
+        munmap(data, size);
+    data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        data = nullptr;
+        size = 0;
+        return false;
+    }
+#else
+    void* grown = realloc(data, bytes);
+    if (!grown)
+        return false;
+    data = grown;
+#endif
+
+    size = bytes;
+    return true;
+}
+
+// Drop the pages of a byte range from resident memory
+void MappedFile::Release(size_t begin, size_t end)
+{
+#ifdef OBJL_HAVE_MMAP
+    size_t page = PageSize();
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+
+    // Dirty pages of a shared file mapping stay in the page
+    //	cache and are written back, nothing is lost
+    if (data && begin < end)
+        madvise((char*)data + begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+// Size of a memory page
+size_t MappedFile::PageSize()
+{
+#ifdef OBJL_HAVE_MMAP
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+#else
+    return 4096;
+#endif
+}
+
+MeshStore::MeshStore()
+    : Origin(0.0), temporary(false), end(0)
+{
+}
+
+MeshStore::~MeshStore()
+{
+    Close();
+}
+
+// Create an empty store
+bool MeshStore::Create(const std::string& Path, const std::string& directory)
+{
+    Close();
+
+    temporary = Path.empty();
+    path = Path;
+    if (temporary)
+    {
+#ifdef OBJL_HAVE_MMAP
+        path = TempDirectoryOr(directory) + "/objl-store-XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if (fd < 0)
+            return false;
+        close(fd);
+#else
+        path = TempDirectoryOr(directory) + "/objl-store-" + std::to_string((uintptr_t)this);
+#endif
+    }
+
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    return file.is_open();
+}
+
+// Close the store
+void MeshStore::Close()
+{
+    std::lock_guard<std::mutex> lock(fileLock);
+    if (file.is_open())
+        file.close();
+    if (temporary && !path.empty())
+        std::remove(path.c_str());
+
+    Entries.clear();
+    path.clear();
+    temporary = false;
+    end = 0;
+}
+
+// Write a newMesh as the next chunk
+bool MeshStore::Append(const std::string& name, const std::string& materialName,
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+    const Bounds& bounds)
+{
+    std::lock_guard<std::mutex> lock(fileLock);
+
+    MeshStoreEntry entry;
+    entry.newMeshName = name;
+    entry.MaterialName = materialName;
+    entry.Offset = end;
+    entry.VertexCount = (uint32_t)vertices.size();
+    entry.IndexCount = (uint32_t)indices.size();
+    entry.newMeshBounds = bounds;
+
+    file.seekp((std::streamoff)end);
+    file.write((const char*)vertices.data(), vertices.size() * sizeof(Vertex));
+    file.write((const char*)indices.data(), indices.size() * sizeof(unsigned int));
+    if (!file)
+        return false;
+
+    end += vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+    Entries.push_back(entry);
+    return true;
+}
+
+// Read a newMesh back, with its material
+bool MeshStore::Read(size_t i, newMesh& oMesh) const
+{
+    if (i >= Entries.size())
+        return false;
+    const MeshStoreEntry& entry = Entries[i];
+
+    std::vector<Vertex> vertices(entry.VertexCount);
+    std::vector<unsigned int> indices(entry.IndexCount);
+    {
+        std::lock_guard<std::mutex> lock(fileLock);
+        file.flush();
+        file.seekg((std::streamoff)entry.Offset);
+        file.read((char*)vertices.data(), vertices.size() * sizeof(Vertex));
+        file.read((char*)indices.data(), indices.size() * sizeof(unsigned int));
+        if (!file)
+        {
+            file.clear();
+            return false;
+        }
+    }
+
+    oMesh = newMesh(vertices, indices);
+    oMesh.newMeshName = entry.newMeshName;
+    oMesh.newMeshBounds = entry.newMeshBounds;
+    for (const Material& m : Materials)
+    {
+        if (m.name == entry.MaterialName)
+        {
+            oMesh.newMeshMaterial = m;
+            break;
+        }
+    }
+    return true;
+}
+
+// Load a file with bounded memory into a MeshStore
+bool LoadFileOutOfCore(const std::string& Path, MeshStore& oStore, const OutOfCoreOptions& options)
+{
+    if (!oStore.Create(options.StorePath, options.TempDirectory))
+        return false;
+
+    LayoutLoader<DefaultVertexTraits, OutOfCoreStorage> loader;
+    loader.RebasePositions = options.RebasePositions;
+
+    // A quarter of the budget for the three tables, which each keep
+    //	up to one and a half times their share resident
+    loader.TableStorage.TempDirectory = options.TempDirectory;
+    loader.TableStorage.ResidentBytes = std::max<size_t>(options.MemoryBudget / 16, 1 << 20);
+
+    // A quarter for the newMesh being parsed, about 80 bytes a vertex
+    //	with its indices and the slack of the growing vectors
+    loader.MaxMeshVertices = std::max<size_t>(options.MemoryBudget / 4 / 80, 1024);
+
+    loader.OnnewMesh = [&](LayoutMesh<Vertex>& mesh, const std::string& materialName)
+    {
+        return oStore.Append(mesh.newMeshName, materialName, mesh.Vertices, mesh.Indices, mesh.newMeshBounds);
+    };
+
+    try
+    {
+        if (!loader.LoadFile(Path))
+            return false;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    oStore.Materials = std::move(loader.LoadedMaterials);
+    oStore.StoreBounds = loader.LoadedBounds;
+    oStore.Origin = loader.LoadedOrigin;
+    return true;
+}
@@ -0,0 +1,255 @@
+#ifndef OBJ_OUTOFCORE_H
+#define OBJ_OUTOFCORE_H
+
+#include <obj_layout.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+// Class: MappedFile
+// Description: A growable temporary file mapped into memory
+//
+// The file is removed as soon as it is created, so it goes away
+// with the process. Pages can be dropped from resident memory
+// and are read back from the file when touched again.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Create an empty file in a directory, the system
+    //	temporary directory when empty
+    bool Create(const std::string& directory);
+
+    // Grow the file and its mapping to at least bytes
+    bool Resize(size_t bytes);
+
+    // Drop the pages of a byte range from resident memory
+    void Release(size_t begin, size_t end);
+
+    // Size of a memory page
+    static size_t PageSize();
+
+    void* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    int fd;
+    void* data;
+    size_t size;
+};
+
+// Bytes a read fault may bring in, file mappings are faulted in
+//	up to 64 KiB around the page that was touched
+static const size_t kReadBlock = 64 << 10;
+
+// Class: MappedArray
+// Description: An array kept in a MappedFile that stays mostly out of resident memory
+//
+// Whenever residentBytes were added or paged in by reads since the
+// last trim, all but the newest elements are released. Reading an
+// element that was released brings its page back from the file (or
+// page cache), along with the pages around it the system maps on the
+// same fault, so every block of kReadBlock bytes that reads touch is
+// counted once.
+template <class T>
+class MappedArray
+{
+public:
+    MappedArray(const std::string& directory = "", size_t residentBytes = 0)
+        : file(new MappedFile()), count(0), capacity(0), trimmed(0), readBlocks(0),
+        block(std::max(MappedFile::PageSize(), kReadBlock)), resident(residentBytes)
+    {
+        if (!file->Create(directory))
+            throw std::bad_alloc();
+    }
+
+    MappedArray(MappedArray&&) = default;
+    MappedArray& operator=(MappedArray&&) = default;
+
+    void push_back(const T& v)
+    {
+        if (count == capacity)
+            Grow();
+        ((T*)file->Data())[count++] = v;
+
+        if (resident && (count - trimmed) * sizeof(T) + readBlocks * block >= resident)
+            Trim();
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) { return ((T*)file->Data())[Read(i)]; }
+    const T& operator[](size_t i) const { return ((const T*)file->Data())[Read(i)]; }
+
+private:
+    // Double the capacity, at least 1 MiB
+    void Grow()
+    {
+        size_t bytes = std::max<size_t>(capacity * sizeof(T) * 2, 1 << 20);
+        if (!file->Resize(bytes))
+            throw std::bad_alloc();
+        capacity = file->Size() / sizeof(T);
+    }
+
+    // Count the block of an element the first time it is read
+    //	after a trim
+    size_t Read(size_t i) const
+    {
+        if (resident)
+        {
+            size_t b = i * sizeof(T) / block;
+            if (b / 64 >= touched.size())
+                touched.resize(b / 64 + 1, 0);
+
+            uint64_t bit = 1ull << (b % 64);
+            if (!(touched[b / 64] & bit))
+            {
+                touched[b / 64] |= bit;
+                if ((count - trimmed) * sizeof(T) + ++readBlocks * block >= resident)
+                    Trim();
+            }
+        }
+        return i;
+    }
+
+    // Release everything but the newest half of the resident bytes
+    void Trim() const
+    {
+        size_t keep = std::min(count, resident / 2 / sizeof(T));
+        file->Release(0, (count - keep) * sizeof(T));
+        trimmed = count;
+        readBlocks = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+    }
+
+    std::unique_ptr<MappedFile> file;
+    size_t count;
+    size_t capacity;
+    mutable size_t trimmed;
+    // Blocks read since the last trim, one bit each
+    mutable std::vector<uint64_t> touched;
+    mutable size_t readBlocks;
+    size_t block;
+    size_t resident;
+};
+
+// Structure: OutOfCoreStorage
+// Description: LayoutLoader storage that keeps the v/vt/vn tables in MappedArrays
+struct OutOfCoreStorage
+{
+    template <class T>
+    using Table = MappedArray<T>;
+
+    template <class T>
+    Table<T> MakeTable() const { return Table<T>(TempDirectory, ResidentBytes); }
+
+    // Directory of the table files, the system temporary directory when empty
+    std::string TempDirectory;
+    // Resident bytes each table may grow by or read before it is trimmed
+    size_t ResidentBytes = 0;
+};
+
+// Structure: MeshStoreEntry
+// Description: Where a newMesh (or a part of one) is in a MeshStore
+struct MeshStoreEntry
+{
+    // newMesh Name, parts of a large newMesh share it
+    std::string newMeshName;
+    // Material name (usemtl)
+    std::string MaterialName;
+    // Byte offset of the vertices, the indices follow them
+    uint64_t Offset = 0;
+    // Number of vertices
+    uint32_t VertexCount = 0;
+    // Number of indices
+    uint32_t IndexCount = 0;
+    // Bounding Box and Sphere
+    Bounds newMeshBounds;
+};
+
+// Class: MeshStore
+// Description: Finished newMeshes written to a chunked file, read back one at a time
+class MeshStore
+{
+public:
+    MeshStore();
+    ~MeshStore();
+    MeshStore(const MeshStore&) = delete;
+    MeshStore& operator=(const MeshStore&) = delete;
+
+    // Create an empty store
+    //
+    // With an empty path the store is a temporary file in
+    // directory that is removed when the store is closed
+    bool Create(const std::string& Path, const std::string& directory = "");
+
+    // Close the store
+    void Close();
+
+    // Write a newMesh as the next chunk
+    bool Append(const std::string& name, const std::string& materialName,
+        const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        const Bounds& bounds);
+
+    // Number of newMeshes in the store
+    size_t Count() const { return Entries.size(); }
+
+    // Read a newMesh back, with its material
+    bool Read(size_t i, newMesh& oMesh) const;
+
+    // Chunk of every newMesh
+    std::vector<MeshStoreEntry> Entries;
+    // Materials of the loaded file
+    std::vector<Material> Materials;
+    // Bounding Box and Sphere of all newMeshes
+    Bounds StoreBounds;
+    // Origin of the positions (RebasePositions)
+    glm::dvec3 Origin;
+
+private:
+    mutable std::mutex fileLock;
+    mutable std::fstream file;
+    std::string path;
+    bool temporary;
+    uint64_t end;
+};
+
+// Structure: OutOfCoreOptions
+// Description: Settings for loading models larger than memory
+struct OutOfCoreOptions
+{
+    OutOfCoreOptions()
+    {
+        MemoryBudget = 256u << 20;
+        RebasePositions = false;
+    }
+
+    // Approximate resident memory the load may use, in bytes
+    size_t MemoryBudget;
+    // Directory of the temporary files, the system temporary directory when empty
+    std::string TempDirectory;
+    // File to keep the newMeshes in, a temporary one when empty
+    std::string StorePath;
+    // Load with RebasePositions
+    bool RebasePositions;
+};
+
+// Load a file with bounded memory into a MeshStore
+//
+// The v/vt/vn tables live in memory mapped temporary files and every
+// newMesh is written to the store when its o/g/usemtl block ends
+// (large ones in parts), so resident memory stays around the budget
+// whatever the file size, also when faces come long after the
+// vertices they use. A quarter of the budget goes to the tables, a
+// quarter to the newMesh being parsed. Faces that jump around
+// tables much larger than their share read them back from the page
+// cache, trading time for the bound.
+bool LoadFileOutOfCore(const std::string& Path, MeshStore& oStore, const OutOfCoreOptions& options = OutOfCoreOptions());
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef OBJ_PARALLEL_H
+#define OBJ_PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Get the number of worker threads to use
+//
+// A value of 0 selects one thread per hardware thread
+inline unsigned int WorkerCount(unsigned int maxThreads = 0)
+{
+    unsigned int count = maxThreads ? maxThreads : std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+// Call func(i) for every i in [0, count)
+//
+// Items are handed out one by one to the worker threads, so
+// items of very different cost (meshes) still balance well.
+template <class Func>
+void ParallelFor(size_t count, Func func, unsigned int maxThreads = 0)
+{
+    size_t nThreads = WorkerCount(maxThreads);
+    if (nThreads > count)
+        nThreads = count;
+
+    // Nothing to gain from threads, run inline
+    if (nThreads <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    workers.reserve(nThreads);
+
+    for (size_t t = 0; t < nThreads; t++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t i = next++; i < count; i = next++)
+                func(i);
+        });
+    }
+
+    for (auto& w : workers)
+        w.join();
+}
+
+#endif
@@ -0,0 +1,127 @@
+// obj_pipeline.cpp - Post-load stages scheduled as chains per newMesh on worker threads
+
+#include <obj_pipeline.h>
+#include <obj_parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+
+typedef std::chrono::steady_clock PipelineClock;
+
+// Nanoseconds since start
+static int64_t Elapsed(PipelineClock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineClock::now() - start).count();
+}
+
+// Add a stage every newMesh runs through
+Pipeline& Pipeline::AddStage(const std::string& name, MeshStage stage)
+{
+    stages.push_back(Stage{ name, std::move(stage), ModelStage() });
+    return *this;
+}
+
+// Add a stage run once all newMeshes are through the stages before it
+Pipeline& Pipeline::AddModelStage(const std::string& name, ModelStage stage)
+{
+    stages.push_back(Stage{ name, MeshStage(), std::move(stage) });
+    return *this;
+}
+
+// Run every stage on the Loaded newMeshes
+PipelineTimings Pipeline::Run(Loader& loader, const PipelineOptions& options) const
+{
+    PipelineClock::time_point start = PipelineClock::now();
+    std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    bool gathered = loader.GatheredLoadednewMeshes();
+    unsigned int workers = WorkerCount(options.MaxThreads);
+
+    // Nanoseconds per stage, summed by the threads
+    std::vector<std::atomic<int64_t>> spent(stages.size());
+    for (std::atomic<int64_t>& ns : spent)
+        ns = 0;
+
+    PipelineTimings timings;
+    timings.Stages.resize(stages.size());
+    for (size_t s = 0; s < stages.size(); s++)
+        timings.Stages[s].Name = stages[s].Name;
+
+    size_t s = 0;
+    while (s < stages.size())
+    {
+        if (stages[s].Model)
+        {
+            if (gathered)
+                loader.GatherLoadednewMeshes();
+
+            PipelineClock::time_point stageStart = PipelineClock::now();
+            stages[s].Model(loader, workers);
+            spent[s] += Elapsed(stageStart);
+            timings.Stages[s].Runs++;
+            s++;
+            continue;
+        }
+
+        // The chain of newMesh stages up to the next model stage
+        size_t end = s;
+        while (end < stages.size() && !stages[end].Model)
+            end++;
+
+        // Largest newMeshes first, so the last ones to finish are short
+        std::vector<size_t> order(meshes.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return meshes[a].Vertices.size() + meshes[a].Indices.size() > meshes[b].Vertices.size() + meshes[b].Indices.size();
+        });
+
+        // newMeshes share the workers while there are enough of them
+        unsigned int meshThreads = std::max<unsigned int>(1, workers / (unsigned int)std::max<size_t>(1, meshes.size()));
+
+        std::exception_ptr failure;
+        std::mutex failureLock;
+        std::atomic<bool> failed(false);
+
+        ParallelFor(order.size(), [&](size_t i)
+        {
+            if (failed)
+                return;
+
+            newMesh& mesh = meshes[order[i]];
+            try
+            {
+                for (size_t k = s; k < end; k++)
+                {
+                    PipelineClock::time_point stageStart = PipelineClock::now();
+                    stages[k].Mesh(mesh, meshThreads);
+                    spent[k] += Elapsed(stageStart);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureLock);
+                if (!failure)
+                    failure = std::current_exception();
+                failed = true;
+            }
+        }, workers);
+
+        if (failure)
+            std::rethrow_exception(failure);
+
+        for (size_t k = s; k < end; k++)
+            timings.Stages[k].Runs += meshes.size();
+        s = end;
+    }
+
+    if (gathered)
+        loader.GatherLoadednewMeshes();
+
+    for (size_t k = 0; k < stages.size(); k++)
+        timings.Stages[k].Seconds = spent[k] * 1e-9;
+    timings.TotalSeconds = Elapsed(start) * 1e-9;
+    return timings;
+}
@@ -0,0 +1,84 @@
+#ifndef OBJ_PIPELINE_H
+#define OBJ_PIPELINE_H
+
+#include <obj_loader.h>
+
+#include <functional>
+
+// Structure: PipelineOptions
+// Description: Settings for running a Pipeline
+struct PipelineOptions
+{
+    PipelineOptions()
+    {
+        MaxThreads = 0;
+    }
+
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Structure: StageTiming
+// Description: Time spent in one stage of a Pipeline
+struct StageTiming
+{
+    // Stage Name
+    std::string Name;
+    // Seconds spent in the stage, summed over all threads
+    double Seconds = 0.0;
+    // Number of times the stage ran (once per newMesh, or once)
+    size_t Runs = 0;
+};
+
+// Structure: PipelineTimings
+// Description: Time spent in a run of a Pipeline
+struct PipelineTimings
+{
+    // Every stage, in the order added
+    std::vector<StageTiming> Stages;
+    // Seconds from start to end of the run
+    double TotalSeconds = 0.0;
+};
+
+// Class: Pipeline
+// Description: Post-load stages scheduled over the loaded newMeshes
+//
+// newMesh stages added one after another form a chain every newMesh
+// runs through on one worker thread, so a newMesh goes through all of
+// them while it is still in cache. Different newMeshes run
+// concurrently, largest first. A model stage waits for every newMesh
+// to finish the stages before it and runs once on the whole model.
+class Pipeline
+{
+public:
+    // A stage run on one newMesh, maxThreads is what it may use
+    //	for itself (1 while other newMeshes run beside it)
+    typedef std::function<void(newMesh& mesh, unsigned int maxThreads)> MeshStage;
+    // A stage run once on the whole model
+    typedef std::function<void(Loader& loader, unsigned int maxThreads)> ModelStage;
+
+    // Add a stage every newMesh runs through
+    Pipeline& AddStage(const std::string& name, MeshStage stage);
+
+    // Add a stage run once all newMeshes are through the stages before it
+    Pipeline& AddModelStage(const std::string& name, ModelStage stage);
+
+    // Run every stage on the Loaded newMeshes
+    //
+    // LoadedVertices and LoadedIndices are rebuilt from the newMeshes
+    // before every model stage and at the end. An exception thrown by
+    // a stage stops the run and is thrown again from here.
+    PipelineTimings Run(Loader& loader, const PipelineOptions& options = PipelineOptions()) const;
+
+private:
+    struct Stage
+    {
+        std::string Name;
+        MeshStage Mesh;
+        ModelStage Model;
+    };
+
+    std::vector<Stage> stages;
+};
+
+#endif
@@ -0,0 +1,100 @@
+// obj_polygon.cpp - On demand triangulation of faces loaded as polygons
+
+#include <obj_polygon.h>
+#include <obj_parallel.h>
+
+#include <algorithm>
+
+// Faces each block of triangulation gets
+static const size_t kBlockSize = 4096;
+
+// Triangulate faces [begin, end) of a newMesh into oIndices
+static void TriangulateRange(std::vector<unsigned int>& oIndices, const newMesh& mesh, size_t begin, size_t end)
+{
+    std::vector<Vertex> faceVerts;
+    std::vector<unsigned int> faceIndices;
+
+    for (size_t f = begin; f < end; f++)
+    {
+        unsigned int first = mesh.FaceOffsets[f], last = mesh.FaceOffsets[f + 1];
+
+        faceVerts.clear();
+        for (unsigned int c = first; c < last; c++)
+            faceVerts.push_back(mesh.Vertices[mesh.FaceCorners[c]]);
+
+        faceIndices.clear();
+        Loader::VertexTriangulation(faceIndices, faceVerts);
+
+        for (unsigned int i : faceIndices)
+            oIndices.push_back(mesh.FaceCorners[first + i]);
+    }
+}
+
+// Triangulate the faces of a newMesh loaded with KeepPolygons into oIndices
+void TriangulateFaces(std::vector<unsigned int>& oIndices, const newMesh& mesh, const TriangulateOptions& options)
+{
+    size_t faces = mesh.FaceOffsets.empty() ? 0 : mesh.FaceOffsets.size() - 1;
+    size_t blocks = (faces + kBlockSize - 1) / kBlockSize;
+
+    std::vector<std::vector<unsigned int>> parts(blocks);
+    ParallelFor(blocks, [&](size_t b)
+    {
+        TriangulateRange(parts[b], mesh, b * kBlockSize, std::min(faces, (b + 1) * kBlockSize));
+    }, options.MaxThreads);
+
+    size_t count = 0;
+    for (const std::vector<unsigned int>& part : parts)
+        count += part.size();
+
+    oIndices.clear();
+    oIndices.reserve(count);
+    for (const std::vector<unsigned int>& part : parts)
+        oIndices.insert(oIndices.end(), part.begin(), part.end());
+}
+
+// Triangulate the faces of a newMesh loaded with KeepPolygons into Indices
+void TriangulateFaces(newMesh& mesh, const TriangulateOptions& options)
+{
+    std::vector<unsigned int> indices;
+    TriangulateFaces(indices, mesh, options);
+    mesh.Indices = std::move(indices);
+}
+
+// Get the triangles of a newMesh
+const std::vector<unsigned int>& TriangleIndices(const newMesh& mesh, std::vector<unsigned int>& scratch,
+    const TriangulateOptions& options)
+{
+    if (!mesh.Indices.empty() || mesh.FaceOffsets.size() < 2)
+        return mesh.Indices;
+
+    TriangulateFaces(scratch, mesh, options);
+    return scratch;
+}
+
+// Triangulate the faces of every loaded newMesh, in parallel
+void TriangulateFaces(Loader& loader, const TriangulateOptions& options)
+{
+    std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+    bool gathered = loader.GatheredLoadednewMeshes();
+
+    // With enough newMeshes to keep every thread busy triangulate one
+    //	newMesh per thread, otherwise give all threads to each newMesh
+    if (meshes.size() >= WorkerCount(options.MaxThreads))
+    {
+        TriangulateOptions single = options;
+        single.MaxThreads = 1;
+
+        ParallelFor(meshes.size(), [&](size_t i)
+        {
+            TriangulateFaces(meshes[i], single);
+        }, options.MaxThreads);
+    }
+    else
+    {
+        for (newMesh& mesh : meshes)
+            TriangulateFaces(mesh, options);
+    }
+
+    if (gathered)
+        loader.GatherLoadednewMeshes();
+}
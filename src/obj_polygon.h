@@ -0,0 +1,43 @@
+#ifndef OBJ_POLYGON_H
+#define OBJ_POLYGON_H
+
+#include <obj_loader.h>
+
+// Structure: TriangulateOptions
+// Description: Settings for triangulating kept polygons
+struct TriangulateOptions
+{
+    TriangulateOptions()
+    {
+        MaxThreads = 0;
+    }
+
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Triangulate the faces of a newMesh loaded with KeepPolygons into Indices
+//
+// Faces are triangulated as LoadFile would, blocks of faces in
+// parallel. The faces are kept.
+void TriangulateFaces(newMesh& mesh, const TriangulateOptions& options = TriangulateOptions());
+
+// Triangulate the faces of a newMesh loaded with KeepPolygons into oIndices
+//
+// The newMesh is left as it is
+void TriangulateFaces(std::vector<unsigned int>& oIndices, const newMesh& mesh, const TriangulateOptions& options = TriangulateOptions());
+
+// Get the triangles of a newMesh
+//
+// Returns Indices, or for a newMesh kept as polygons and not
+// triangulated yet its faces triangulated into scratch, so
+// triangle passes take either kind of newMesh
+const std::vector<unsigned int>& TriangleIndices(const newMesh& mesh, std::vector<unsigned int>& scratch,
+    const TriangulateOptions& options = TriangulateOptions());
+
+// Triangulate the faces of every loaded newMesh, in parallel
+//
+// LoadedIndices is rebuilt to match
+void TriangulateFaces(Loader& loader, const TriangulateOptions& options = TriangulateOptions());
+
+#endif
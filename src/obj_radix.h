@@ -0,0 +1,81 @@
+#ifndef OBJ_RADIX_H
+#define OBJ_RADIX_H
+
+#include <obj_parallel.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Bits sorted in every radix pass
+const unsigned int kRadixDigitBits = 11;
+const unsigned int kRadixDigitCount = 1u << kRadixDigitBits;
+
+// Keys each radix sort block should at least get
+const size_t kRadixMinBlockSize = 16384;
+
+// Sort values by their keys, stable, using the low keyBits bits of the keys
+//
+// Every pass counts the digits of each block in parallel, turns
+// the counts into per block offsets and scatters in parallel.
+// Passes whose digit is the same for every key are skipped.
+inline void RadixSortPairs(std::vector<uint64_t>& keys, std::vector<unsigned int>& values,
+    unsigned int keyBits, unsigned int maxThreads)
+{
+    size_t n = keys.size();
+    size_t nBlocks = std::max<size_t>(1, std::min<size_t>(WorkerCount(maxThreads) * 4, n / kRadixMinBlockSize));
+    size_t blockSize = (n + nBlocks - 1) / nBlocks;
+
+    std::vector<uint64_t> keysTmp(n);
+    std::vector<unsigned int> valuesTmp(n);
+    std::vector<size_t> counts(nBlocks * kRadixDigitCount);
+
+    for (unsigned int shift = 0; shift < keyBits; shift += kRadixDigitBits)
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+
+        ParallelFor(nBlocks, [&](size_t b)
+        {
+            size_t* c = &counts[b * kRadixDigitCount];
+            size_t end = std::min(n, (b + 1) * blockSize);
+            for (size_t i = b * blockSize; i < end; i++)
+                c[(keys[i] >> shift) & (kRadixDigitCount - 1)]++;
+        }, maxThreads);
+
+        // Turn the counts into the first output slot of every
+        //	digit in every block, digits first then blocks
+        bool single = false;
+        size_t sum = 0;
+        for (size_t d = 0; d < kRadixDigitCount; d++)
+        {
+            size_t digitStart = sum;
+            for (size_t b = 0; b < nBlocks; b++)
+            {
+                size_t c = counts[b * kRadixDigitCount + d];
+                counts[b * kRadixDigitCount + d] = sum;
+                sum += c;
+            }
+            if (sum - digitStart == n)
+                single = true;
+        }
+        if (single)
+            continue;
+
+        ParallelFor(nBlocks, [&](size_t b)
+        {
+            size_t* c = &counts[b * kRadixDigitCount];
+            size_t end = std::min(n, (b + 1) * blockSize);
+            for (size_t i = b * blockSize; i < end; i++)
+            {
+                size_t slot = c[(keys[i] >> shift) & (kRadixDigitCount - 1)]++;
+                keysTmp[slot] = keys[i];
+                valuesTmp[slot] = values[i];
+            }
+        }, maxThreads);
+
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+#endif
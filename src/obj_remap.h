@@ -0,0 +1,65 @@
+#ifndef OBJ_REMAP_H
+#define OBJ_REMAP_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Hash a block of 32 bit words
+inline uint32_t HashWords(const void* data, size_t size)
+{
+    uint32_t h = 2166136261u;
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i + 4 <= size; i += 4)
+    {
+        uint32_t k;
+        memcpy(&k, p + i, 4);
+        k *= 0x5bd1e995;
+        k ^= k >> 24;
+        h = (h * 0x5bd1e995) ^ (k * 0x5bd1e995);
+    }
+    return h ^ (h >> 15);
+}
+
+// Give every item an id, items whose keys are bitwise equal share the id
+//
+// key(item) returns a reference to the part of the item to compare.
+// oRemap gets the id of every item, oFirst the first item of every id
+template <class T, class Key>
+void BuildRemap(std::vector<unsigned int>& oRemap, std::vector<unsigned int>& oFirst,
+    const std::vector<T>& items, Key key)
+{
+    size_t tableSize = 1;
+    while (tableSize < items.size() * 2)
+        tableSize *= 2;
+
+    std::vector<unsigned int> table(tableSize, ~0u);
+    oRemap.resize(items.size());
+    oFirst.clear();
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const auto& k = key(items[i]);
+        size_t slot = HashWords(&k, sizeof(k)) & (tableSize - 1);
+
+        while (true)
+        {
+            unsigned int id = table[slot];
+            if (id == ~0u)
+            {
+                table[slot] = (unsigned int)oFirst.size();
+                oRemap[i] = (unsigned int)oFirst.size();
+                oFirst.push_back((unsigned int)i);
+                break;
+            }
+            if (memcmp(&key(items[oFirst[id]]), &k, sizeof(k)) == 0)
+            {
+                oRemap[i] = id;
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,223 @@
+// obj_reorder.cpp - Morton order reordering of vertices and triangles
+
+#include <obj_reorder.h>
+#include <obj_parallel.h>
+#include <obj_radix.h>
+
+#include <algorithm>
+
+// Elements each block of code computing gets
+static const size_t kBlockSize = 16384;
+
+// Vertex not placed yet
+static const unsigned int kUnplaced = 0xffffffffu;
+
+// Spread the low 10 bits of x to every third bit
+static uint32_t Spread10(uint32_t x)
+{
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+// Spread the low 21 bits of x to every third bit
+static uint64_t Spread21(uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | (x << 32)) & 0x001f00000000ffffull;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+    x = (x | (x << 8)) & 0x100f00f00f00f00full;
+    x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+    x = (x | (x << 2)) & 0x1249249249249249ull;
+    return x;
+}
+
+// Place a coordinate on a grid of maxCell + 1 cells along [lo, hi]
+static uint32_t Quantize(float v, float lo, float hi, uint32_t maxCell)
+{
+    if (!(hi > lo))
+        return 0;
+    float t = (v - lo) / (hi - lo) * float(maxCell);
+    return t <= 0.0f ? 0 : (t >= float(maxCell) ? maxCell : uint32_t(t + 0.5f));
+}
+
+// Get the 30 bit Morton code of a point in a box
+uint32_t MortonCode30(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    return (Spread10(Quantize(p.x, boxMin.x, boxMax.x, 0x3ff)) << 2)
+        | (Spread10(Quantize(p.y, boxMin.y, boxMax.y, 0x3ff)) << 1)
+        | Spread10(Quantize(p.z, boxMin.z, boxMax.z, 0x3ff));
+}
+
+// Get the 63 bit Morton code of a point in a box
+uint64_t MortonCode63(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    return (Spread21(Quantize(p.x, boxMin.x, boxMax.x, 0x1fffff)) << 2)
+        | (Spread21(Quantize(p.y, boxMin.y, boxMax.y, 0x1fffff)) << 1)
+        | Spread21(Quantize(p.z, boxMin.z, boxMax.z, 0x1fffff));
+}
+
+// Compute the codes of count points and sort their ids by them
+template <class Point>
+static void SortByCode(std::vector<unsigned int>& oOrder, size_t count, Point point,
+    const glm::vec3& boxMin, const glm::vec3& boxMax, const ReorderOptions& options)
+{
+    std::vector<uint64_t> keys(count);
+    oOrder.resize(count);
+
+    ParallelFor((count + kBlockSize - 1) / kBlockSize, [&](size_t b)
+    {
+        size_t end = std::min(count, (b + 1) * kBlockSize);
+        for (size_t i = b * kBlockSize; i < end; i++)
+        {
+            glm::vec3 p = point(i);
+            keys[i] = options.WideCodes ? MortonCode63(p, boxMin, boxMax) : MortonCode30(p, boxMin, boxMax);
+            oOrder[i] = (unsigned int)i;
+        }
+    }, options.MaxThreads);
+
+    RadixSortPairs(keys, oOrder, options.WideCodes ? 63 : 30, options.MaxThreads);
+}
+
+// Renumber the vertices of a newMesh, remap[old] is the new index
+static void RemapVertices(newMesh& mesh, const std::vector<unsigned int>& remap, const ReorderOptions& options)
+{
+    std::vector<Vertex> sorted(mesh.Vertices.size());
+    for (size_t i = 0; i < remap.size(); i++)
+        sorted[remap[i]] = mesh.Vertices[i];
+    mesh.Vertices.swap(sorted);
+
+    if (mesh.Colors.size() == remap.size())
+    {
+        std::vector<glm::vec3> sortedColors(remap.size());
+        for (size_t i = 0; i < remap.size(); i++)
+            sortedColors[remap[i]] = mesh.Colors[i];
+        mesh.Colors.swap(sortedColors);
+    }
+
+    auto remapIndices = [&](std::vector<unsigned int>& indices)
+    {
+        ParallelFor((indices.size() + kBlockSize - 1) / kBlockSize, [&](size_t b)
+        {
+            size_t end = std::min(indices.size(), (b + 1) * kBlockSize);
+            for (size_t i = b * kBlockSize; i < end; i++)
+                indices[i] = remap[indices[i]];
+        }, options.MaxThreads);
+    };
+
+    remapIndices(mesh.Indices);
+    for (std::vector<unsigned int>& lod : mesh.LODIndices)
+        remapIndices(lod);
+    remapIndices(mesh.FaceCorners);
+    remapIndices(mesh.LineIndices);
+    remapIndices(mesh.PointIndices);
+}
+
+// Reorder a newMesh along the Morton curve of a box
+void SpatialReorder(newMesh& mesh, const glm::vec3& boxMin, const glm::vec3& boxMax, const ReorderOptions& options)
+{
+    const std::vector<Vertex>& verts = mesh.Vertices;
+    std::vector<unsigned int> order;
+
+    size_t triangles = mesh.Indices.size() / 3;
+    if (options.ReorderTriangles && triangles > 1)
+    {
+        const std::vector<unsigned int>& indices = mesh.Indices;
+        SortByCode(order, triangles, [&](size_t t)
+        {
+            return (verts[indices[3 * t]].Position + verts[indices[3 * t + 1]].Position + verts[indices[3 * t + 2]].Position) * (1.0f / 3.0f);
+        }, boxMin, boxMax, options);
+
+        // Indices past the last whole triangle stay at the end
+        std::vector<unsigned int> sorted(indices.size());
+        for (size_t t = 0; t < triangles; t++)
+        {
+            for (int c = 0; c < 3; c++)
+                sorted[3 * t + c] = indices[3 * order[t] + c];
+        }
+        std::copy(indices.begin() + 3 * triangles, indices.end(), sorted.begin() + 3 * triangles);
+        mesh.Indices.swap(sorted);
+    }
+
+    if (!options.ReorderVertices || verts.empty())
+        return;
+
+    // Sort the vertices by their own codes, then with the triangles
+    //	sorted let the referenced ones follow them: a vertex goes
+    //	where its first triangle is, so the triangles read the vertex
+    //	buffer front to back (Loader gives every face corner its own
+    //	vertex, which no order of the vertices alone can match)
+    SortByCode(order, verts.size(), [&](size_t i) { return verts[i].Position; }, boxMin, boxMax, options);
+
+    std::vector<unsigned int> remap(verts.size(), kUnplaced);
+    unsigned int next = 0;
+    if (options.ReorderTriangles)
+    {
+        for (unsigned int index : mesh.Indices)
+        {
+            if (remap[index] == kUnplaced)
+                remap[index] = next++;
+        }
+    }
+    for (unsigned int i : order)
+    {
+        if (remap[i] == kUnplaced)
+            remap[i] = next++;
+    }
+
+    RemapVertices(mesh, remap, options);
+}
+
+// Reorder a newMesh along the Morton curve of its own bounds
+void SpatialReorder(newMesh& mesh, const ReorderOptions& options)
+{
+    Bounds bounds = mesh.newMeshBounds;
+    if (bounds.Empty())
+    {
+        for (const Vertex& v : mesh.Vertices)
+            bounds.Add(v.Position);
+    }
+    SpatialReorder(mesh, bounds.Min, bounds.Max, options);
+}
+
+// Reorder every loaded newMesh along the Morton curve of the model box
+void SpatialReorder(Loader& loader, const ReorderOptions& options)
+{
+    std::vector<newMesh>& meshes = loader.LoadednewMeshes;
+
+    Bounds bounds = loader.LoadedBounds;
+    if (bounds.Empty())
+    {
+        for (const newMesh& mesh : meshes)
+        {
+            for (const Vertex& v : mesh.Vertices)
+                bounds.Add(v.Position);
+        }
+    }
+
+    // With enough newMeshes to keep every thread busy sort one
+    //	newMesh per thread, otherwise give all threads to each sort
+    if (meshes.size() >= WorkerCount(options.MaxThreads))
+    {
+        ReorderOptions single = options;
+        single.MaxThreads = 1;
+
+        ParallelFor(meshes.size(), [&](size_t i)
+        {
+            SpatialReorder(meshes[i], bounds.Min, bounds.Max, single);
+        }, options.MaxThreads);
+    }
+    else
+    {
+        for (newMesh& mesh : meshes)
+            SpatialReorder(mesh, bounds.Min, bounds.Max, options);
+    }
+
+    // Sorting keeps the sizes, so this still tells whether the
+    //	Loaded lists held the newMeshes before
+    if (loader.GatheredLoadednewMeshes())
+        loader.GatherLoadednewMeshes();
+}
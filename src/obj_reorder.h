@@ -0,0 +1,55 @@
+#ifndef OBJ_REORDER_H
+#define OBJ_REORDER_H
+
+#include <obj_loader.h>
+
+#include <cstdint>
+
+// Structure: ReorderOptions
+// Description: Settings for spatial reordering
+struct ReorderOptions
+{
+    ReorderOptions()
+    {
+        WideCodes = false;
+        ReorderVertices = true;
+        ReorderTriangles = true;
+        MaxThreads = 0;
+    }
+
+    // Use 63 bit Morton codes (21 bits an axis) instead of 30 bit
+    //	(10 bits an axis), for large models with fine detail
+    bool WideCodes;
+    // Sort the vertices of every newMesh, by the code of their
+    //	first triangle when ReorderTriangles is set, by the code of
+    //	their position otherwise
+    bool ReorderVertices;
+    // Sort the triangles of every newMesh by the code of their center
+    bool ReorderTriangles;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Get the 30 bit Morton code of a point in a box
+uint32_t MortonCode30(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+// Get the 63 bit Morton code of a point in a box
+uint64_t MortonCode63(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+// Reorder a newMesh along the Morton curve of a box
+//
+// Triangles are radix sorted by the codes of their centers in
+// parallel, then vertices are renumbered to follow them, Indices
+// and LODIndices are remapped to match.
+void SpatialReorder(newMesh& mesh, const glm::vec3& boxMin, const glm::vec3& boxMax,
+    const ReorderOptions& options = ReorderOptions());
+
+// Reorder a newMesh along the Morton curve of its own bounds
+void SpatialReorder(newMesh& mesh, const ReorderOptions& options = ReorderOptions());
+
+// Reorder every loaded newMesh along the Morton curve of the model box
+//
+// LoadedVertices and LoadedIndices are rebuilt to match
+void SpatialReorder(Loader& loader, const ReorderOptions& options = ReorderOptions());
+
+#endif
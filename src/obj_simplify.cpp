@@ -0,0 +1,428 @@
+// obj_simplify.cpp - Quadric error mesh simplification and LOD generation
+
+#include <obj_simplify.h>
+#include <obj_parallel.h>
+#include <obj_polygon.h>
+#include <obj_remap.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+// Border edges that are not locked get a plane quadric
+//	this many times stronger than their length squared
+static const float kBorderWeight = 10.0f;
+
+// Structure: Quadric
+// Description: Sum of squared distances to a set of area weighted planes
+struct Quadric
+{
+    double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double w = 0;
+};
+
+// Add the plane n.x + d = 0 with weight w to a quadric
+static void QuadricAddPlane(Quadric& q, const glm::vec3& n, float d, float w)
+{
+    q.a00 += w * n.x * n.x;
+    q.a11 += w * n.y * n.y;
+    q.a22 += w * n.z * n.z;
+    q.a01 += w * n.x * n.y;
+    q.a02 += w * n.x * n.z;
+    q.a12 += w * n.y * n.z;
+    q.b0 += w * n.x * d;
+    q.b1 += w * n.y * d;
+    q.b2 += w * n.z * d;
+    q.c += w * d * d;
+    q.w += w;
+}
+
+// Add two quadrics
+static void QuadricAdd(Quadric& q, const Quadric& r)
+{
+    q.a00 += r.a00;
+    q.a11 += r.a11;
+    q.a22 += r.a22;
+    q.a01 += r.a01;
+    q.a02 += r.a02;
+    q.a12 += r.a12;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.w += r.w;
+}
+
+// Mean squared distance of v to the planes of a quadric
+static double QuadricError(const Quadric& q, const glm::vec3& v)
+{
+    if (q.w <= 0)
+        return 0;
+
+    double x = v.x, y = v.y, z = v.z;
+    double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+        + 2 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+        + 2 * (q.b0 * x + q.b1 * y + q.b2 * z)
+        + q.c;
+
+    return fabs(e) / q.w;
+}
+
+// Simplify an index list down to targetIndexCount indices
+float SimplifyIndices(std::vector<unsigned int>& oIndices,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    size_t targetIndexCount,
+    const SimplifyOptions& options)
+{
+    oIndices.clear();
+
+    if (iVerts.empty() || iIndices.size() < 3)
+        return 0.0f;
+
+    // Unique vertices (wedges) and unique positions
+    std::vector<unsigned int> vertWedge, wedgeVert;
+    BuildRemap(vertWedge, wedgeVert, iVerts, [](const Vertex& v) -> const Vertex& { return v; });
+
+    std::vector<unsigned int> vertPos, posVert;
+    BuildRemap(vertPos, posVert, iVerts, [](const Vertex& v) -> const glm::vec3& { return v.Position; });
+
+    size_t wedgeCount = wedgeVert.size();
+    size_t posCount = posVert.size();
+
+    // Work in a unit cube so errors are relative to the extent
+    glm::vec3 minP = iVerts[0].Position, maxP = iVerts[0].Position;
+    for (const Vertex& v : iVerts)
+    {
+        minP = glm::min(minP, v.Position);
+        maxP = glm::max(maxP, v.Position);
+    }
+    glm::vec3 ext = maxP - minP;
+    float extent = std::max(ext.x, std::max(ext.y, ext.z));
+    float scale = extent > 0 ? 1.0f / extent : 1.0f;
+
+    std::vector<glm::vec3> pos(posCount);
+    for (size_t p = 0; p < posCount; p++)
+        pos[p] = (iVerts[posVert[p]].Position - minP) * scale;
+
+    // Wedge attributes and the list of wedges of every position
+    std::vector<unsigned int> wedgePos(wedgeCount);
+    std::vector<glm::vec3> wedgeNormal(wedgeCount);
+    std::vector<glm::vec2> wedgeUV(wedgeCount);
+    std::vector<unsigned int> wedgeFirst(posCount, ~0u), wedgeNext(wedgeCount, ~0u);
+
+    for (size_t u = 0; u < wedgeCount; u++)
+    {
+        const Vertex& v = iVerts[wedgeVert[u]];
+        float len = MagnitudeV3(v.Normal);
+
+        wedgePos[u] = vertPos[wedgeVert[u]];
+        wedgeNormal[u] = len > 0 ? v.Normal / len : glm::vec3(0, 0, 0);
+        wedgeUV[u] = v.TextureCoordinate;
+        wedgeNext[u] = wedgeFirst[wedgePos[u]];
+        wedgeFirst[wedgePos[u]] = (unsigned int)u;
+    }
+
+    // Triangles over wedges, without the degenerate ones
+    std::vector<unsigned int> tris;
+    tris.reserve(iIndices.size());
+    for (size_t i = 0; i + 2 < iIndices.size(); i += 3)
+    {
+        unsigned int a = vertWedge[iIndices[i]], b = vertWedge[iIndices[i + 1]], c = vertWedge[iIndices[i + 2]];
+        if (wedgePos[a] == wedgePos[b] || wedgePos[b] == wedgePos[c] || wedgePos[a] == wedgePos[c])
+            continue;
+        tris.push_back(a);
+        tris.push_back(b);
+        tris.push_back(c);
+    }
+
+    // Plane quadrics of every position
+    std::vector<Quadric> quadrics(posCount);
+    std::vector<glm::vec3> triNormal(tris.size() / 3);
+    for (size_t t = 0; t < tris.size() / 3; t++)
+    {
+        const glm::vec3& p0 = pos[wedgePos[tris[t * 3]]];
+        const glm::vec3& p1 = pos[wedgePos[tris[t * 3 + 1]]];
+        const glm::vec3& p2 = pos[wedgePos[tris[t * 3 + 2]]];
+
+        glm::vec3 n = CrossV3(p1 - p0, p2 - p0);
+        float area = MagnitudeV3(n);
+        if (area > 0)
+            n = n / area;
+        triNormal[t] = n;
+
+        for (int k = 0; k < 3; k++)
+            QuadricAddPlane(quadrics[wedgePos[tris[t * 3 + k]]], n, -DotV3(n, p0), area * 0.5f);
+    }
+
+    // Find the open (and non-manifold) edges
+    std::vector<uint64_t> edges;
+    edges.reserve(tris.size());
+    for (size_t t = 0; t < tris.size() / 3; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t a = wedgePos[tris[t * 3 + k]], b = wedgePos[tris[t * 3 + (k + 1) % 3]];
+            uint64_t key = a < b ? (a << 32) | b : (b << 32) | a;
+            edges.push_back(key);
+        }
+    }
+    std::vector<uint64_t> sortedEdges = edges;
+    std::sort(sortedEdges.begin(), sortedEdges.end());
+
+    std::vector<char> locked(posCount, 0);
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        auto range = std::equal_range(sortedEdges.begin(), sortedEdges.end(), edges[i]);
+        if (range.second - range.first == 2)
+            continue;
+
+        unsigned int a = (unsigned int)(edges[i] >> 32), b = (unsigned int)(edges[i] & 0xffffffffu);
+        if (options.LockBorder || range.second - range.first > 2)
+        {
+            locked[a] = 1;
+            locked[b] = 1;
+        }
+        else
+        {
+            // Keep the border in place with a plane through the
+            //	edge perpendicular to its triangle
+            glm::vec3 e = pos[b] - pos[a];
+            glm::vec3 n = CrossV3(e, triNormal[i / 3]);
+            float len = MagnitudeV3(n);
+            if (len <= 0)
+                continue;
+            n = n / len;
+
+            float w = DotV3(e, e) * kBorderWeight;
+            QuadricAddPlane(quadrics[a], n, -DotV3(n, pos[a]), w);
+            QuadricAddPlane(quadrics[b], n, -DotV3(n, pos[a]), w);
+        }
+    }
+
+    // Cost of moving every wedge of p0 onto its closest wedge of p1
+    auto attributeCost = [&](unsigned int p0, unsigned int p1, std::vector<unsigned int>* oMap)
+    {
+        double worst = 0;
+        for (unsigned int u = wedgeFirst[p0]; u != ~0u; u = wedgeNext[u])
+        {
+            double best = DBL_MAX;
+            unsigned int bestWedge = wedgeFirst[p1];
+            for (unsigned int v = wedgeFirst[p1]; v != ~0u; v = wedgeNext[v])
+            {
+                glm::vec3 dn = wedgeNormal[u] - wedgeNormal[v];
+                glm::vec2 dt = wedgeUV[u] - wedgeUV[v];
+                double d = options.NormalWeight * DotV3(dn, dn) + options.UVWeight * (dt.x * dt.x + dt.y * dt.y);
+                if (d < best)
+                {
+                    best = d;
+                    bestWedge = v;
+                }
+            }
+            if (oMap)
+                (*oMap)[u] = bestWedge;
+            worst = std::max(worst, best);
+        }
+        return worst;
+    };
+
+    struct Collapse
+    {
+        unsigned int p0, p1;
+        double cost, error;
+    };
+
+    size_t targetTris = targetIndexCount / 3;
+    double maxError = double(options.MaxError) * options.MaxError;
+    double resultError = 0;
+
+    std::vector<unsigned int> wedgeRemap(wedgeCount);
+    std::vector<unsigned int> adjStart(posCount + 1), adjTris;
+    std::vector<char> touched(posCount);
+    std::vector<Collapse> collapses;
+
+    while (tris.size() / 3 > targetTris)
+    {
+        size_t triCount = tris.size() / 3;
+
+        // Triangles around every position
+        std::fill(adjStart.begin(), adjStart.end(), 0);
+        for (unsigned int u : tris)
+            adjStart[wedgePos[u] + 1]++;
+        for (size_t p = 0; p < posCount; p++)
+            adjStart[p + 1] += adjStart[p];
+        adjTris.resize(tris.size());
+        {
+            std::vector<unsigned int> fill(adjStart.begin(), adjStart.end() - 1);
+            for (size_t i = 0; i < tris.size(); i++)
+                adjTris[fill[wedgePos[tris[i]]]++] = (unsigned int)(i / 3);
+        }
+
+        // Cheapest direction of every edge
+        edges.clear();
+        for (size_t i = 0; i < tris.size(); i++)
+        {
+            uint64_t a = wedgePos[tris[i]], b = wedgePos[tris[i - i % 3 + (i + 1) % 3]];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t e : edges)
+        {
+            unsigned int a = (unsigned int)(e >> 32), b = (unsigned int)(e & 0xffffffffu);
+
+            Quadric q = quadrics[a];
+            QuadricAdd(q, quadrics[b]);
+
+            Collapse best = { 0, 0, DBL_MAX, 0 };
+            if (!locked[a])
+            {
+                double err = QuadricError(q, pos[b]);
+                double cost = err + attributeCost(a, b, nullptr);
+                if (cost < best.cost)
+                    best = { a, b, cost, err };
+            }
+            if (!locked[b])
+            {
+                double err = QuadricError(q, pos[a]);
+                double cost = err + attributeCost(b, a, nullptr);
+                if (cost < best.cost)
+                    best = { b, a, cost, err };
+            }
+            if (best.cost <= maxError)
+                collapses.push_back(best);
+        }
+
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+        // Apply the cheapest collapses that do not overlap
+        std::fill(touched.begin(), touched.end(), 0);
+        for (size_t u = 0; u < wedgeCount; u++)
+            wedgeRemap[u] = (unsigned int)u;
+
+        size_t removed = 0;
+        size_t applied = 0;
+        for (const Collapse& c : collapses)
+        {
+            if (triCount - removed <= targetTris)
+                break;
+            if (touched[c.p0] || touched[c.p1])
+                continue;
+
+            // Reject collapses that flip a triangle around p0
+            bool flips = false;
+            size_t dying = 0;
+            for (unsigned int k = adjStart[c.p0]; k < adjStart[c.p0 + 1] && !flips; k++)
+            {
+                unsigned int t = adjTris[k];
+                unsigned int tp[3] = { wedgePos[tris[t * 3]], wedgePos[tris[t * 3 + 1]], wedgePos[tris[t * 3 + 2]] };
+                if (tp[0] == c.p1 || tp[1] == c.p1 || tp[2] == c.p1)
+                {
+                    dying++;
+                    continue;
+                }
+
+                glm::vec3 before = GenTriNormal(pos[tp[0]], pos[tp[1]], pos[tp[2]]);
+                for (int j = 0; j < 3; j++)
+                    if (tp[j] == c.p0)
+                        tp[j] = c.p1;
+                glm::vec3 after = GenTriNormal(pos[tp[0]], pos[tp[1]], pos[tp[2]]);
+
+                if (DotV3(before, after) <= 1e-2f * MagnitudeV3(before) * MagnitudeV3(after))
+                    flips = true;
+            }
+            if (flips)
+                continue;
+
+            attributeCost(c.p0, c.p1, &wedgeRemap);
+            QuadricAdd(quadrics[c.p1], quadrics[c.p0]);
+            resultError = std::max(resultError, c.error);
+
+            // Everything around p0 changes, keep it out of this pass
+            for (unsigned int k = adjStart[c.p0]; k < adjStart[c.p0 + 1]; k++)
+            {
+                unsigned int t = adjTris[k];
+                for (int j = 0; j < 3; j++)
+                    touched[wedgePos[tris[t * 3 + j]]] = 1;
+            }
+
+            removed += dying;
+            applied++;
+        }
+
+        if (applied == 0)
+            break;
+
+        // Move the triangles onto the surviving wedges
+        size_t write = 0;
+        for (size_t i = 0; i < tris.size(); i += 3)
+        {
+            unsigned int a = wedgeRemap[tris[i]], b = wedgeRemap[tris[i + 1]], c = wedgeRemap[tris[i + 2]];
+            if (wedgePos[a] == wedgePos[b] || wedgePos[b] == wedgePos[c] || wedgePos[a] == wedgePos[c])
+                continue;
+            tris[write++] = a;
+            tris[write++] = b;
+            tris[write++] = c;
+        }
+        tris.resize(write);
+    }
+
+    // Back to the original vertices
+    oIndices.resize(tris.size());
+    for (size_t i = 0; i < tris.size(); i++)
+        oIndices[i] = wedgeVert[tris[i]];
+
+    return float(sqrt(resultError));
+}
+
+// Generate the LOD chain of a newMesh into LODIndices/LODErrors
+void GenerateLODs(newMesh& mesh, const SimplifyOptions& options)
+{
+    mesh.LODIndices.clear();
+    mesh.LODErrors.clear();
+
+    // A newMesh kept as polygons is triangulated first
+    TriangulateOptions triangulate;
+    triangulate.MaxThreads = options.MaxThreads;
+    std::vector<unsigned int> triangulated;
+    const std::vector<unsigned int>& indices = TriangleIndices(mesh, triangulated, triangulate);
+
+    float error = 0.0f;
+
+    for (float ratio : options.LODRatios)
+    {
+        const std::vector<unsigned int>& source = mesh.LODIndices.empty() ? indices : mesh.LODIndices.back();
+
+        size_t target = size_t(indices.size() * ratio) / 3 * 3;
+        if (target >= source.size())
+            continue;
+
+        std::vector<unsigned int> lod;
+        float lodError = SimplifyIndices(lod, mesh.Vertices, source, target, options);
+
+        // Could not be reduced any further
+        if (lod.empty() || lod.size() >= source.size())
+            break;
+
+        error += lodError;
+        mesh.LODIndices.push_back(std::move(lod));
+        mesh.LODErrors.push_back(error);
+    }
+}
+
+// Generate the LOD chain of every loaded newMesh, in parallel
+void GenerateLODs(Loader& loader, const SimplifyOptions& options)
+{
+    SimplifyOptions single = options;
+    single.MaxThreads = 1;
+
+    ParallelFor(loader.LoadednewMeshes.size(), [&](size_t i)
+    {
+        GenerateLODs(loader.LoadednewMeshes[i], single);
+    }, options.MaxThreads);
+}
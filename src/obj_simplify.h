@@ -0,0 +1,60 @@
+#ifndef OBJ_SIMPLIFY_H
+#define OBJ_SIMPLIFY_H
+
+#include <obj_loader.h>
+
+// Structure: SimplifyOptions
+// Description: Settings for the quadric error mesh simplification
+struct SimplifyOptions
+{
+    SimplifyOptions()
+    {
+        LODRatios = { 0.5f, 0.25f, 0.125f };
+        MaxError = 0.01f;
+        NormalWeight = 0.05f;
+        UVWeight = 0.05f;
+        LockBorder = true;
+        MaxThreads = 0;
+    }
+
+    // Index count of each LOD relative to the full newMesh
+    std::vector<float> LODRatios;
+    // Largest error a collapse may introduce, relative to the newMesh extent
+    float MaxError;
+    // Cost of changing the normal of a vertex
+    float NormalWeight;
+    // Cost of changing the texture coordinate of a vertex
+    float UVWeight;
+    // Keep open borders in place, these are the material
+    //	boundaries between neighbouring newMeshes
+    bool LockBorder;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Simplify an index list down to targetIndexCount indices
+//
+// Edges are collapsed in order of their quadric error plus the
+// normal and texture coordinate change, until the target is
+// reached or the next collapse would exceed MaxError.
+//
+// The output indexes into the same vertex list as the input.
+// Returns the error of the result relative to the mesh extent.
+float SimplifyIndices(std::vector<unsigned int>& oIndices,
+    const std::vector<Vertex>& iVerts,
+    const std::vector<unsigned int>& iIndices,
+    size_t targetIndexCount,
+    const SimplifyOptions& options = SimplifyOptions());
+
+// Generate the LOD chain of a newMesh into LODIndices/LODErrors
+//
+// Each level is simplified from the previous one, the chain
+// ends early once a level can not be reduced any further. A newMesh
+// kept as polygons (KeepPolygons) is simplified from its faces
+// triangulated, Indices stays empty.
+void GenerateLODs(newMesh& mesh, const SimplifyOptions& options = SimplifyOptions());
+
+// Generate the LOD chain of every loaded newMesh, in parallel
+void GenerateLODs(Loader& loader, const SimplifyOptions& options = SimplifyOptions());
+
+#endif
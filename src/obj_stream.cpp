@@ -0,0 +1,228 @@
+// obj_stream.cpp - Pipelined decompression of .obj.gz / .obj.zst input
+
+#include <obj_stream.h>
+
+#include <cstdio>
+#include <ios>
+
+#ifdef OBJL_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef OBJL_USE_ZSTD
+#include <zstd.h>
+#endif
+
+PipelinedStreamBuf::PipelinedStreamBuf(ReadFunc read, size_t blockSize, size_t blockCount)
+    : read(read), ring(blockCount < 2 ? 2 : blockCount),
+    head(0), tail(0), filled(0), holding(false), done(false), stop(false), failed(false)
+{
+    for (Block& b : ring)
+        b.data.resize(blockSize);
+
+    producer = std::thread(&PipelinedStreamBuf::Produce, this);
+}
+
+PipelinedStreamBuf::~PipelinedStreamBuf()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    changed.notify_all();
+    producer.join();
+}
+
+// Check if the producer hit an error
+bool PipelinedStreamBuf::Failed()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return failed;
+}
+
+// Producer thread loop
+void PipelinedStreamBuf::Produce()
+{
+    while (true)
+    {
+        size_t slot;
+        {
+            // Wait for a free block
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return stop || filled < ring.size(); });
+            if (stop)
+                return;
+            slot = tail;
+        }
+
+        // Fill it without holding the lock
+        Block& b = ring[slot];
+        long long got = read(b.data.data(), b.data.size());
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (got <= 0)
+            {
+                failed = got < 0;
+                done = true;
+            }
+            else
+            {
+                b.size = (size_t)got;
+                tail = (tail + 1) % ring.size();
+                filled++;
+            }
+        }
+        changed.notify_all();
+
+        if (got <= 0)
+            return;
+    }
+}
+
+std::streambuf::int_type PipelinedStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    std::unique_lock<std::mutex> guard(lock);
+
+    // Give the block just read back to the producer
+    if (holding)
+    {
+        holding = false;
+        head = (head + 1) % ring.size();
+        filled--;
+        changed.notify_all();
+    }
+
+    changed.wait(guard, [&]() { return filled > 0 || done; });
+
+    // A truncated or corrupt file ends mid line, throwing sets badbit
+    //	on the istream so getline fails instead of handing out that line
+    if (filled == 0 && failed)
+        throw std::ios_base::failure("compressed input is corrupt or truncated");
+    if (filled == 0)
+        return traits_type::eof();
+
+    holding = true;
+    Block& b = ring[head];
+    setg(b.data.data(), b.data.data(), b.data.data() + b.size);
+    return traits_type::to_int_type(*gptr());
+}
+
+// Check if a path ends with a suffix
+static bool EndsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Check if a path names a compressed .obj (.obj.gz / .obj.zst)
+bool IsCompressedOBJ(const std::string& Path)
+{
+    return EndsWith(Path, ".obj.gz") || EndsWith(Path, ".obj.zst");
+}
+
+// Open a compressed .obj, decompressing on a separate thread
+std::unique_ptr<PipelinedStreamBuf> OpenCompressedOBJ(const std::string& Path)
+{
+#ifdef OBJL_USE_ZLIB
+    if (EndsWith(Path, ".obj.gz"))
+    {
+        gzFile gz = gzopen(Path.c_str(), "rb");
+        if (!gz)
+            return nullptr;
+        gzbuffer(gz, 1 << 18);
+
+        std::shared_ptr<gzFile_s> file(gz, [](gzFile f) { gzclose(f); });
+        return std::unique_ptr<PipelinedStreamBuf>(new PipelinedStreamBuf(
+            [file](char* buffer, size_t capacity) -> long long
+            {
+                int n = gzread(file.get(), buffer, (unsigned int)capacity);
+
+                // A short read is the end of the file or an error, a
+                //	truncated file reports Z_BUF_ERROR
+                if (n >= 0 && (size_t)n < capacity)
+                {
+                    int error = Z_OK;
+                    gzerror(file.get(), &error);
+                    if (error != Z_OK)
+                        return -1;
+                }
+                return n;
+            }));
+    }
+#endif
+
+#ifdef OBJL_USE_ZSTD
+    if (EndsWith(Path, ".obj.zst"))
+    {
+        // Compressed input and decoder state of one .zst file
+        struct ZstdSource
+        {
+            FILE* file = nullptr;
+            ZSTD_DCtx* ctx = nullptr;
+            std::vector<char> in;
+            ZSTD_inBuffer input = { nullptr, 0, 0 };
+            bool eof = false;
+            // Last hint of the decoder, 0 once a frame is complete
+            size_t hint = 0;
+
+            ~ZstdSource()
+            {
+                if (ctx)
+                    ZSTD_freeDCtx(ctx);
+                if (file)
+                    fclose(file);
+            }
+        };
+
+        std::shared_ptr<ZstdSource> src = std::make_shared<ZstdSource>();
+        src->file = fopen(Path.c_str(), "rb");
+        src->ctx = ZSTD_createDCtx();
+        if (!src->file || !src->ctx)
+            return nullptr;
+        src->in.resize(ZSTD_DStreamInSize());
+
+        return std::unique_ptr<PipelinedStreamBuf>(new PipelinedStreamBuf(
+            [src](char* buffer, size_t capacity) -> long long
+            {
+                ZSTD_outBuffer out = { buffer, capacity, 0 };
+                while (out.pos < out.size)
+                {
+                    if (src->input.pos == src->input.size && !src->eof)
+                    {
+                        size_t n = fread(src->in.data(), 1, src->in.size(), src->file);
+                        if (n == 0)
+                            src->eof = true;
+                        else
+                            src->input = { src->in.data(), n, 0 };
+                    }
+
+                    size_t before = out.pos;
+                    size_t r = ZSTD_decompressStream(src->ctx, &out, &src->input);
+                    if (ZSTD_isError(r))
+                        return -1;
+                    src->hint = r;
+
+                    // Input used up and nothing left in the decoder, a
+                    //	frame still waiting for input is truncated
+                    if (src->eof && src->input.pos == src->input.size && out.pos == before)
+                    {
+                        if (src->hint != 0)
+                            return -1;
+                        break;
+                    }
+                }
+                return (long long)out.pos;
+            }));
+    }
+#endif
+
+#if !defined(OBJL_USE_ZLIB) && !defined(OBJL_USE_ZSTD)
+    // Built without any decompressor
+    (void)Path;
+#endif
+
+    return nullptr;
+}
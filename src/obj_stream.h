@@ -0,0 +1,71 @@
+#ifndef OBJ_STREAM_H
+#define OBJ_STREAM_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compressed .obj input
+//
+// Define OBJL_USE_ZLIB to read .obj.gz (link zlib)
+// Define OBJL_USE_ZSTD to read .obj.zst (link zstd)
+
+// Class: PipelinedStreamBuf
+// Description: Input stream buffer filled by a producer running on its own thread
+//
+// The producer fills a bounded ring of blocks while the reader
+// consumes the previous ones, so producing (decompressing) and
+// parsing overlap and no more than the ring is ever held.
+class PipelinedStreamBuf : public std::streambuf
+{
+public:
+    // Fill up to capacity bytes, return the count, 0 at the end or -1 on error
+    typedef std::function<long long(char* buffer, size_t capacity)> ReadFunc;
+
+    PipelinedStreamBuf(ReadFunc read, size_t blockSize = 1 << 20, size_t blockCount = 4);
+    ~PipelinedStreamBuf();
+
+    // Check if the producer hit an error
+    bool Failed();
+
+protected:
+    int_type underflow() override;
+
+private:
+    // Producer thread loop
+    void Produce();
+
+    struct Block
+    {
+        std::vector<char> data;
+        size_t size = 0;
+    };
+
+    ReadFunc read;
+    std::vector<Block> ring;
+    // Next block to consume, next block to fill, blocks ready
+    size_t head, tail, filled;
+    // The reader holds the head block
+    bool holding;
+    bool done, stop, failed;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread producer;
+};
+
+// Check if a path names a compressed .obj (.obj.gz / .obj.zst)
+bool IsCompressedOBJ(const std::string& Path);
+
+// Open a compressed .obj, decompressing on a separate thread
+//
+// Returns nullptr if the file can not be opened or its format
+// was not compiled in
+std::unique_ptr<PipelinedStreamBuf> OpenCompressedOBJ(const std::string& Path);
+
+#endif
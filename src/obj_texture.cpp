@@ -0,0 +1,346 @@
+// obj_texture.cpp - Texture preflight: resolving, de-duplicating and probing material maps
+
+#include <obj_texture.h>
+#include <obj_parallel.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+// Big endian 16 and 32 bit values
+static unsigned int ReadBE16(const unsigned char* p)
+{
+    return (unsigned int)p[0] << 8 | p[1];
+}
+
+static unsigned int ReadBE32(const unsigned char* p)
+{
+    return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 | (unsigned int)p[2] << 8 | p[3];
+}
+
+// Little endian 16 bit value
+static unsigned int ReadLE16(const unsigned char* p)
+{
+    return (unsigned int)p[1] << 8 | p[0];
+}
+
+// Read the IHDR chunk that follows the PNG signature
+static bool ProbePNG(std::istream& file, TextureInfo& oInfo)
+{
+    // Length, "IHDR", width, height, bit depth, color type
+    unsigned char h[18];
+    if (!file.read((char*)h, sizeof(h)) || std::memcmp(h + 4, "IHDR", 4) != 0)
+        return false;
+
+    unsigned int channels;
+    switch (h[17])
+    {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 3; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default: return false;
+    }
+
+    oInfo.Format = ImageFormat::PNG;
+    oInfo.Width = ReadBE32(h + 8);
+    oInfo.Height = ReadBE32(h + 12);
+    oInfo.Channels = channels;
+    // Palette indices decode to 8 bit colors
+    oInfo.BitDepth = h[17] == 3 ? 8 : h[16];
+    return true;
+}
+
+// Walk the JPEG markers after SOI up to the frame header
+static bool ProbeJPEG(std::istream& file, TextureInfo& oInfo)
+{
+    while (true)
+    {
+        if (file.get() != 0xFF)
+            return false;
+
+        // Any number of fill bytes may come before a marker
+        int marker;
+        do
+        {
+            marker = file.get();
+        } while (marker == 0xFF);
+
+        if (marker == EOF)
+            return false;
+
+        // Markers without a segment
+        if (marker == 0x01 || marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7))
+            continue;
+
+        // End of image or start of scan before any frame header
+        if (marker == 0xD9 || marker == 0xDA)
+            return false;
+
+        unsigned char len[2];
+        if (!file.read((char*)len, 2) || ReadBE16(len) < 2)
+            return false;
+
+        // Start of frame, any coding (DHT, JPG and DAC share the range)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+            // Precision, height, width, components
+            unsigned char h[6];
+            if (!file.read((char*)h, sizeof(h)))
+                return false;
+
+            oInfo.Format = ImageFormat::JPEG;
+            oInfo.BitDepth = h[0];
+            oInfo.Height = ReadBE16(h + 1);
+            oInfo.Width = ReadBE16(h + 3);
+            oInfo.Channels = h[5];
+            return true;
+        }
+
+        file.seekg(ReadBE16(len) - 2, std::ios::cur);
+    }
+}
+
+// Read the 18 byte TGA header
+static bool ProbeTGA(std::istream& file, TextureInfo& oInfo)
+{
+    unsigned char h[18];
+    if (!file.read((char*)h, sizeof(h)))
+        return false;
+
+    unsigned int type = h[2];
+    unsigned int depth = h[16];
+    unsigned int channels;
+    switch (type)
+    {
+    // Color mapped
+    case 1:
+    case 9:
+        if (h[1] != 1)
+            return false;
+        channels = 3;
+        break;
+    // True color
+    case 2:
+    case 10:
+        if (depth != 15 && depth != 16 && depth != 24 && depth != 32)
+            return false;
+        channels = depth == 32 ? 4 : 3;
+        break;
+    // Grayscale
+    case 3:
+    case 11:
+        if (depth != 8 && depth != 16)
+            return false;
+        channels = depth / 8;
+        break;
+    default:
+        return false;
+    }
+
+    oInfo.Format = ImageFormat::TGA;
+    oInfo.Width = ReadLE16(h + 12);
+    oInfo.Height = ReadLE16(h + 14);
+    oInfo.Channels = channels;
+    oInfo.BitDepth = 8;
+    return oInfo.Width && oInfo.Height;
+}
+
+// Read the header of an image file into oInfo
+bool ProbeImage(const std::string& Path, TextureInfo& oInfo)
+{
+    std::error_code ec;
+    oInfo.FileSize = std::filesystem::file_size(Path, ec);
+    oInfo.Exists = !ec;
+    if (ec)
+    {
+        oInfo.FileSize = 0;
+        return false;
+    }
+
+    std::ifstream file(Path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    unsigned char sig[8];
+    if (file.read((char*)sig, 8))
+    {
+        static const unsigned char png[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        if (std::memcmp(sig, png, 8) == 0)
+            return ProbePNG(file, oInfo);
+
+        if (sig[0] == 0xFF && sig[1] == 0xD8)
+        {
+            file.seekg(2);
+            return ProbeJPEG(file, oInfo);
+        }
+    }
+
+    std::string ext = std::filesystem::path(Path).extension().string();
+    for (char& c : ext)
+        c = (char)std::tolower((unsigned char)c);
+    if (ext != ".tga")
+        return false;
+
+    file.clear();
+    file.seekg(0);
+    return ProbeTGA(file, oInfo);
+}
+
+// Number of arguments every map option takes, -1 for 1 to 3 numbers
+static int MapOptionArguments(const std::string& option)
+{
+    static const std::unordered_map<std::string, int> options =
+    {
+        { "-blendu", 1 }, { "-blendv", 1 }, { "-bm", 1 }, { "-boost", 1 },
+        { "-cc", 1 }, { "-clamp", 1 }, { "-imfchan", 1 }, { "-mm", 2 },
+        { "-texres", 1 }, { "-type", 1 }, { "-o", -1 }, { "-s", -1 }, { "-t", -1 }
+    };
+
+    auto it = options.find(option);
+    return it == options.end() ? 0 : it->second;
+}
+
+// Whether a token is a number
+static bool IsNumber(const std::string& token)
+{
+    char* end = nullptr;
+    std::strtod(token.c_str(), &end);
+    return !token.empty() && *end == '\0';
+}
+
+// File name of a map statement, without its options
+std::string MapFileName(const std::string& map)
+{
+    std::istringstream in(map);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (in >> token)
+        tokens.push_back(token);
+
+    size_t i = 0;
+    while (i < tokens.size() && tokens[i].size() > 1 && tokens[i][0] == '-')
+    {
+        int arguments = MapOptionArguments(tokens[i]);
+        if (arguments == 0)
+            break;
+        i++;
+
+        if (arguments > 0)
+        {
+            i += arguments;
+        }
+        else
+        {
+            for (int n = 0; n < 3 && i < tokens.size() && IsNumber(tokens[i]); n++)
+                i++;
+        }
+    }
+
+    // Names may have spaces in them
+    std::string name;
+    for (; i < tokens.size(); i++)
+    {
+        if (!name.empty())
+            name += ' ';
+        name += tokens[i];
+    }
+    return name;
+}
+
+// Resolve a map file name against the directory of its library
+static std::string ResolveTexturePath(const std::string& name, const std::filesystem::path& directory)
+{
+    std::string generic = name;
+    for (char& c : generic)
+    {
+        if (c == '\\')
+            c = '/';
+    }
+
+    std::filesystem::path path(generic);
+    if (path.is_relative())
+        path = directory / path;
+    return path.lexically_normal().string();
+}
+
+// Find, de-duplicate and probe the textures of material libraries
+void PreflightTextures(TextureSet& oSet, const std::vector<std::shared_ptr<const MaterialLibrary>>& libraries,
+    const TextureOptions& options)
+{
+    oSet = TextureSet();
+
+    static const struct
+    {
+        const char* Map;
+        std::string Material::* Field;
+    } maps[] =
+    {
+        { "map_Ka", &Material::map_Ka }, { "map_Kd", &Material::map_Kd },
+        { "map_Ks", &Material::map_Ks }, { "map_Ns", &Material::map_Ns },
+        { "map_d", &Material::map_d }, { "map_bump", &Material::map_bump }
+    };
+
+    std::unordered_map<std::string, unsigned int> textureIndex;
+    unsigned int materialIndex = 0;
+
+    for (const auto& library : libraries)
+    {
+        std::filesystem::path directory = std::filesystem::path(library->Path).parent_path();
+
+        for (const Material& material : library->Materials)
+        {
+            for (const auto& map : maps)
+            {
+                const std::string& statement = material.*map.Field;
+                if (statement.empty())
+                    continue;
+
+                std::string name = MapFileName(statement);
+                if (name.empty())
+                    continue;
+
+                std::string path = ResolveTexturePath(name, directory);
+                auto it = textureIndex.emplace(path, (unsigned int)oSet.Textures.size());
+                if (it.second)
+                {
+                    oSet.Textures.emplace_back();
+                    oSet.Textures.back().Path = path;
+                }
+
+                TextureUse use;
+                use.MaterialIndex = materialIndex;
+                use.Map = map.Map;
+                use.TextureIndex = it.first->second;
+                oSet.Uses.push_back(use);
+            }
+            materialIndex++;
+        }
+    }
+
+    // Probing is mostly waiting on the file system, one file per item
+    ParallelFor(oSet.Textures.size(), [&](size_t i)
+    {
+        ProbeImage(oSet.Textures[i].Path, oSet.Textures[i]);
+    }, options.MaxThreads);
+
+    for (const TextureInfo& texture : oSet.Textures)
+    {
+        if (!texture.Exists)
+            oSet.Missing++;
+        else if (texture.Format == ImageFormat::Unknown)
+            oSet.Unreadable++;
+        oSet.DecodedSize += texture.DecodedSize();
+    }
+}
+
+// Find, de-duplicate and probe the textures of the loaded materials
+void PreflightTextures(TextureSet& oSet, const Loader& loader, const TextureOptions& options)
+{
+    PreflightTextures(oSet, loader.LoadedLibraries, options);
+}
@@ -0,0 +1,116 @@
+#ifndef OBJ_TEXTURE_H
+#define OBJ_TEXTURE_H
+
+#include <obj_loader.h>
+#include <obj_mtlcache.h>
+
+#include <cstdint>
+
+// Enum: ImageFormat
+// Description: File formats whose headers are read by ProbeImage
+enum class ImageFormat
+{
+    Unknown,
+    PNG,
+    JPEG,
+    TGA
+};
+
+// Structure: TextureInfo
+// Description: A texture file referenced by the loaded materials
+struct TextureInfo
+{
+    // Path resolved against the directory of the .mtl file
+    std::string Path;
+    // Whether the file exists
+    bool Exists = false;
+    // Size of the file in bytes
+    uint64_t FileSize = 0;
+    // Format read from the header, Unknown when unreadable
+    ImageFormat Format = ImageFormat::Unknown;
+    // Dimensions in pixels
+    unsigned int Width = 0;
+    unsigned int Height = 0;
+    // Channels once decoded (palettes count as RGB)
+    unsigned int Channels = 0;
+    // Bits per channel
+    unsigned int BitDepth = 0;
+
+    // Bytes of the decoded pixels, without mipmaps
+    uint64_t DecodedSize() const
+    {
+        return (uint64_t)Width * Height * Channels * ((BitDepth + 7) / 8);
+    }
+};
+
+// Structure: TextureUse
+// Description: One texture map of one loaded material
+struct TextureUse
+{
+    // Index into the materials of the libraries in turn (CollectMaterials)
+    unsigned int MaterialIndex = 0;
+    // Map statement (map_Ka, map_Kd, map_Ks, map_Ns, map_d, map_bump)
+    const char* Map = "";
+    // Index into TextureSet::Textures
+    unsigned int TextureIndex = 0;
+};
+
+// Structure: TextureSet
+// Description: The distinct textures of the loaded materials
+struct TextureSet
+{
+    // Every texture once, in the order first used
+    std::vector<TextureInfo> Textures;
+    // Every texture map of every material
+    std::vector<TextureUse> Uses;
+    // Textures whose file does not exist
+    size_t Missing = 0;
+    // Textures that exist but whose header could not be read
+    size_t Unreadable = 0;
+    // Sum of TextureInfo::DecodedSize
+    uint64_t DecodedSize = 0;
+};
+
+// Structure: TextureOptions
+// Description: Settings for the texture preflight
+struct TextureOptions
+{
+    TextureOptions()
+    {
+        MaxThreads = 0;
+    }
+
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+};
+
+// Read the header of an image file into oInfo
+//
+// Fills Exists, FileSize, Format, Width, Height, Channels and
+// BitDepth. Returns false when the file is missing or is not a
+// PNG, JPEG or TGA file (TGA has no signature, it is recognized
+// by its .tga extension and a valid header).
+bool ProbeImage(const std::string& Path, TextureInfo& oInfo);
+
+// File name of a map statement, without its options
+//
+// Options such as -s, -o or -bm and their arguments are skipped,
+// "-s 2 2 1 wood.png" gives "wood.png". Names may have spaces.
+std::string MapFileName(const std::string& map);
+
+// Find, de-duplicate and probe the textures of material libraries
+//
+// Map paths are resolved against the directory of the library that
+// names them (backslashes read as separators, map options such as
+// -s or -bm skipped), so the same file named from several materials
+// or libraries is probed once. Files are probed in parallel and no
+// pixel data is read, so uploads can be planned and their memory
+// budgeted first. Material indices count through the libraries in
+// turn, as CollectMaterials lists them.
+void PreflightTextures(TextureSet& oSet, const std::vector<std::shared_ptr<const MaterialLibrary>>& libraries,
+    const TextureOptions& options = TextureOptions());
+
+// Find, de-duplicate and probe the textures of the loaded materials
+void PreflightTextures(TextureSet& oSet, const Loader& loader, const TextureOptions& options = TextureOptions());
+
+#endif
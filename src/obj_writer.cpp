@@ -0,0 +1,361 @@
+// obj_writer.cpp - Fast .obj/.mtl output
+
+#include <obj_writer.h>
+#include <obj_mtlcache.h>
+#include <obj_parallel.h>
+#include <obj_remap.h>
+
+#include <algorithm>
+#include <charconv>
+
+// Longest text of a float, a double and an index
+static const size_t kMaxFloatChars = 16;
+static const size_t kMaxDoubleChars = 24;
+static const size_t kMaxIndexChars = 20;
+
+// Write a float in its shortest round trip form
+static char* PutFloat(char* p, float v)
+{
+    return std::to_chars(p, p + kMaxFloatChars, v).ptr;
+}
+
+// Write a double in its shortest round trip form
+static char* PutDouble(char* p, double v)
+{
+    return std::to_chars(p, p + kMaxDoubleChars, v).ptr;
+}
+
+// Write an unsigned integer
+static char* PutUInt(char* p, unsigned long long v)
+{
+    return std::to_chars(p, p + kMaxIndexChars, v).ptr;
+}
+
+// Write a record of 1 to 3 floats, like "v 1 2 3"
+static char* PutRecord(char* p, const char* token, const float* v, int count)
+{
+    while (*token)
+        *p++ = *token++;
+    for (int i = 0; i < count; i++)
+    {
+        *p++ = ' ';
+        p = PutFloat(p, v[i]);
+    }
+    *p++ = '\n';
+    return p;
+}
+
+// Append records of 1 to 3 floats to a string
+static void AppendRecord(std::string& out, const char* token, const float* v, int count)
+{
+    char buf[8 + 3 * (kMaxFloatChars + 1)];
+    out.append(buf, PutRecord(buf, token, v, count));
+}
+
+// Get the file name part of a path
+static std::string FileName(const std::string& Path)
+{
+    size_t slash = Path.find_last_of("/\\");
+    return slash == std::string::npos ? Path : Path.substr(slash + 1);
+}
+
+// Write a block of text to a file in one call
+static bool WriteText(const std::string& Path, const std::vector<const std::string*>& parts)
+{
+    std::ofstream file(Path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    for (const std::string* p : parts)
+        file.write(p->data(), p->size());
+
+    return bool(file);
+}
+
+// Write materials to a .mtl file
+bool WriteMTL(const std::string& Path, const std::vector<Material>& materials)
+{
+    std::string out;
+    out.reserve(materials.size() * 256);
+
+    for (const Material& m : materials)
+    {
+        out += "newmtl " + m.name + "\n";
+        AppendRecord(out, "Ka", &m.Ka.x, 3);
+        AppendRecord(out, "Kd", &m.Kd.x, 3);
+        AppendRecord(out, "Ks", &m.Ks.x, 3);
+        AppendRecord(out, "Ns", &m.Ns, 1);
+        AppendRecord(out, "Ni", &m.Ni, 1);
+        AppendRecord(out, "d", &m.d, 1);
+        out += "illum " + std::to_string(m.illum) + "\n";
+
+        const std::pair<const char*, const std::string*> maps[] = {
+            { "map_Ka", &m.map_Ka }, { "map_Kd", &m.map_Kd }, { "map_Ks", &m.map_Ks },
+            { "map_Ns", &m.map_Ns }, { "map_d", &m.map_d }, { "map_bump", &m.map_bump } };
+        for (const auto& map : maps)
+        {
+            if (!map.second->empty())
+                out += std::string(map.first) + " " + *map.second + "\n";
+        }
+        out += '\n';
+    }
+
+    return WriteText(Path, { &out });
+}
+
+// Structure: ColoredPosition
+// Description: Position and color of a vertex, welded together
+struct ColoredPosition
+{
+    glm::vec3 Position;
+    glm::vec3 Color;
+};
+
+// Structure: MeshText
+// Description: The formatted records of one newMesh
+struct MeshText
+{
+    // o/usemtl and v/vt/vn records
+    std::string attributes;
+    // f, l and p records
+    std::string faces;
+
+    // Index of every vertex into the written v, vt and vn lists
+    std::vector<unsigned int> positionRemap, tcoordRemap, normalRemap;
+    std::vector<unsigned int> positionFirst, tcoordFirst, normalFirst;
+};
+
+// Write newMeshes to an .obj file
+bool WriteOBJ(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const WriteOptions& options)
+{
+    return WriteOBJ(Path, meshes, materials, std::vector<std::string>(), options);
+}
+
+// Write newMeshes to an .obj file, with the usemtl name of every newMesh
+bool WriteOBJ(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const std::vector<std::string>& materialNames,
+    const WriteOptions& options)
+{
+    std::vector<MeshText> texts(meshes.size());
+    bool rebased = options.Origin != glm::dvec3(0.0);
+
+    // Pick the attributes to write and format them
+    ParallelFor(meshes.size(), [&](size_t i)
+    {
+        const newMesh& mesh = meshes[i];
+        MeshText& t = texts[i];
+        bool colored = !mesh.Colors.empty();
+
+        if (options.WeldVertices)
+        {
+            // A v record carries the color, so colors split positions
+            if (colored)
+            {
+                std::vector<ColoredPosition> positions(mesh.Vertices.size());
+                for (size_t v = 0; v < positions.size(); v++)
+                    positions[v] = { mesh.Vertices[v].Position, mesh.Colors[v] };
+                BuildRemap(t.positionRemap, t.positionFirst, positions, [](const ColoredPosition& c) -> const ColoredPosition& { return c; });
+            }
+            else
+            {
+                BuildRemap(t.positionRemap, t.positionFirst, mesh.Vertices, [](const Vertex& v) -> const glm::vec3& { return v.Position; });
+            }
+            BuildRemap(t.tcoordRemap, t.tcoordFirst, mesh.Vertices, [](const Vertex& v) -> const glm::vec2& { return v.TextureCoordinate; });
+            BuildRemap(t.normalRemap, t.normalFirst, mesh.Vertices, [](const Vertex& v) -> const glm::vec3& { return v.Normal; });
+        }
+        else
+        {
+            t.positionRemap.resize(mesh.Vertices.size());
+            for (size_t v = 0; v < mesh.Vertices.size(); v++)
+                t.positionRemap[v] = (unsigned int)v;
+            t.positionFirst = t.tcoordRemap = t.tcoordFirst = t.normalRemap = t.normalFirst = t.positionRemap;
+        }
+
+        std::string header;
+        if (!mesh.newMeshName.empty())
+            header += "o " + mesh.newMeshName + "\n";
+        const std::string& material = i < materialNames.size() && !materialNames[i].empty()
+            ? materialNames[i] : mesh.GetMaterial().name;
+        if (!material.empty())
+            header += "usemtl " + material + "\n";
+
+        // Format straight into a buffer sized for the longest records
+        size_t records = t.positionFirst.size()
+            + (options.WriteTCoords ? t.tcoordFirst.size() : 0)
+            + (options.WriteNormals ? t.normalFirst.size() : 0);
+        t.attributes.resize(header.size() + records * (4 + 3 * (kMaxDoubleChars + 1))
+            + (colored ? t.positionFirst.size() * 3 * (kMaxFloatChars + 1) : 0));
+
+        char* p = &t.attributes[0];
+        p = std::copy(header.begin(), header.end(), p);
+
+        for (unsigned int v : t.positionFirst)
+        {
+            const glm::vec3& position = mesh.Vertices[v].Position;
+            if (!rebased && !colored)
+            {
+                p = PutRecord(p, "v", &position.x, 3);
+                continue;
+            }
+
+            *p++ = 'v';
+            for (int c = 0; c < 3; c++)
+            {
+                *p++ = ' ';
+                if (rebased)
+                    p = PutDouble(p, options.Origin[c] + double(position[c]));
+                else
+                    p = PutFloat(p, position[c]);
+            }
+
+            // Vertex color, v x y z r g b
+            for (int c = 0; colored && c < 3; c++)
+            {
+                *p++ = ' ';
+                p = PutFloat(p, mesh.Colors[v][c]);
+            }
+            *p++ = '\n';
+        }
+        if (options.WriteTCoords)
+        {
+            for (unsigned int v : t.tcoordFirst)
+                p = PutRecord(p, "vt", &mesh.Vertices[v].TextureCoordinate.x, 2);
+        }
+        if (options.WriteNormals)
+        {
+            for (unsigned int v : t.normalFirst)
+                p = PutRecord(p, "vn", &mesh.Vertices[v].Normal.x, 3);
+        }
+
+        t.attributes.resize(p - t.attributes.data());
+    }, options.MaxThreads);
+
+    // Attribute numbering continues across newMeshes
+    std::vector<size_t> positionBase(meshes.size()), tcoordBase(meshes.size()), normalBase(meshes.size());
+    size_t positions = 0, tcoords = 0, normals = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        positionBase[i] = positions;
+        tcoordBase[i] = tcoords;
+        normalBase[i] = normals;
+        positions += texts[i].positionFirst.size();
+        tcoords += texts[i].tcoordFirst.size();
+        normals += texts[i].normalFirst.size();
+    }
+
+    // Format the faces
+    ParallelFor(meshes.size(), [&](size_t i)
+    {
+        const newMesh& mesh = meshes[i];
+        MeshText& t = texts[i];
+
+        // A newMesh kept as polygons is written as its faces, n-gons
+        //	and all, otherwise as triangles
+        bool polygons = mesh.FaceOffsets.size() >= 2;
+        size_t faceCount = polygons ? mesh.FaceOffsets.size() - 1 : mesh.Indices.size() / 3;
+        size_t cornerCount = polygons ? mesh.FaceCorners.size() : faceCount * 3;
+
+        t.faces.resize(faceCount * 2 + cornerCount * (3 * (kMaxIndexChars + 1))
+            + mesh.LineIndices.size() / 2 * (2 + 2 * (2 * (kMaxIndexChars + 1)))
+            + mesh.PointIndices.size() * (3 + kMaxIndexChars));
+        char* p = &t.faces[0];
+
+        for (size_t f = 0; f < faceCount; f++)
+        {
+            const unsigned int* corners = polygons ? mesh.FaceCorners.data() + mesh.FaceOffsets[f] : mesh.Indices.data() + f * 3;
+            size_t count = polygons ? mesh.FaceOffsets[f + 1] - mesh.FaceOffsets[f] : 3;
+
+            *p++ = 'f';
+            for (size_t c = 0; c < count; c++)
+            {
+                unsigned int v = corners[c];
+                *p++ = ' ';
+                p = PutUInt(p, positionBase[i] + t.positionRemap[v] + 1);
+                if (options.WriteTCoords || options.WriteNormals)
+                {
+                    *p++ = '/';
+                    if (options.WriteTCoords)
+                        p = PutUInt(p, tcoordBase[i] + t.tcoordRemap[v] + 1);
+                }
+                if (options.WriteNormals)
+                {
+                    *p++ = '/';
+                    p = PutUInt(p, normalBase[i] + t.normalRemap[v] + 1);
+                }
+            }
+            *p++ = '\n';
+        }
+
+        // Line segments, l v/vt v/vt
+        for (size_t k = 0; k + 1 < mesh.LineIndices.size(); k += 2)
+        {
+            *p++ = 'l';
+            for (int c = 0; c < 2; c++)
+            {
+                unsigned int v = mesh.LineIndices[k + c];
+                *p++ = ' ';
+                p = PutUInt(p, positionBase[i] + t.positionRemap[v] + 1);
+                if (options.WriteTCoords)
+                {
+                    *p++ = '/';
+                    p = PutUInt(p, tcoordBase[i] + t.tcoordRemap[v] + 1);
+                }
+            }
+            *p++ = '\n';
+        }
+
+        // Points, p v
+        for (unsigned int v : mesh.PointIndices)
+        {
+            *p++ = 'p';
+            *p++ = ' ';
+            p = PutUInt(p, positionBase[i] + t.positionRemap[v] + 1);
+            *p++ = '\n';
+        }
+
+        t.faces.resize(p - t.faces.data());
+    }, options.MaxThreads);
+
+    // Materials next to the .obj
+    std::string header = "# OBJ Loader\n";
+    if (!materials.empty())
+    {
+        std::string mtlPath = Path;
+        if (mtlPath.size() >= 4 && mtlPath.substr(mtlPath.size() - 4) == ".obj")
+            mtlPath.resize(mtlPath.size() - 4);
+        mtlPath += ".mtl";
+
+        if (!WriteMTL(mtlPath, materials))
+            return false;
+
+        header += "mtllib " + FileName(mtlPath) + "\n";
+    }
+
+    std::vector<const std::string*> parts;
+    parts.push_back(&header);
+    for (const MeshText& t : texts)
+    {
+        parts.push_back(&t.attributes);
+        parts.push_back(&t.faces);
+    }
+
+    return WriteText(Path, parts);
+}
+
+// Write the loaded newMeshes and materials of a loader
+bool WriteOBJ(const std::string& Path, const Loader& loader, const WriteOptions& options)
+{
+    WriteOptions rebased = options;
+    rebased.Origin = loader.LoadedOrigin;
+
+    // Materials are copied for writing only when the load did not
+    std::vector<Material> collected;
+    const std::vector<Material>& materials = loader.CopyMaterials
+        ? loader.LoadedMaterials : (collected = CollectMaterials(loader.LoadedLibraries));
+    return WriteOBJ(Path, loader.LoadednewMeshes, materials, loader.LoadedMaterialNames, rebased);
+}
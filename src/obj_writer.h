@@ -0,0 +1,63 @@
+#ifndef OBJ_WRITER_H
+#define OBJ_WRITER_H
+
+#include <obj_loader.h>
+
+// Structure: WriteOptions
+// Description: Settings for writing .obj/.mtl files
+struct WriteOptions
+{
+    WriteOptions()
+    {
+        WeldVertices = false;
+        WriteNormals = true;
+        WriteTCoords = true;
+        MaxThreads = 0;
+        Origin = glm::dvec3(0.0);
+    }
+
+    // Write every distinct position, texture coordinate and
+    //	normal of a newMesh once and share them between faces
+    bool WeldVertices;
+    // Write vn records and face normal indices
+    bool WriteNormals;
+    // Write vt records and face texture coordinate indices
+    bool WriteTCoords;
+    // Worker threads to use, 0 for one per hardware thread
+    unsigned int MaxThreads;
+    // Added to every position, in double precision, to undo
+    //	Loader::RebasePositions (the Loader overload uses LoadedOrigin)
+    glm::dvec3 Origin;
+};
+
+// Write materials to a .mtl file
+bool WriteMTL(const std::string& Path, const std::vector<Material>& materials);
+
+// Write newMeshes to an .obj file
+//
+// Every newMesh is formatted into its own buffer in parallel,
+// with shortest round trip floats, and the buffers are written
+// out in order. When materials are given they are written to a
+// .mtl file next to it, which the .obj refers to with mtllib.
+// newMeshes loaded with KeepPolygons are written as their faces,
+// vertex colors as v x y z r g b, lines and points as l and p.
+bool WriteOBJ(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const WriteOptions& options = WriteOptions());
+
+// Write newMeshes to an .obj file, with the usemtl name of every newMesh
+//
+// materialNames (as Loader::LoadedMaterialNames) keeps the binding
+// of newMeshes whose material was not loaded, an empty name or list
+// falls back to the name of newMesh::GetMaterial()
+bool WriteOBJ(const std::string& Path,
+    const std::vector<newMesh>& meshes,
+    const std::vector<Material>& materials,
+    const std::vector<std::string>& materialNames,
+    const WriteOptions& options = WriteOptions());
+
+// Write the loaded newMeshes and materials of a loader
+bool WriteOBJ(const std::string& Path, const Loader& loader, const WriteOptions& options = WriteOptions());
+
+#endif